@@ -0,0 +1,236 @@
+/**
+ * @file 27_expression_templates.cpp
+ * @brief Demonstrates expression templates that fuse chained elementwise arithmetic into a single loop.
+ *
+ * `add<T>(T a, T b)` from 16_functions.cpp evaluates eagerly. That is fine for two numbers, but
+ * applied to containers `add(add(a, b), c)` builds a full temporary vector for the inner call and
+ * then walks memory a second time for the outer one. A chain of k operations therefore makes
+ * k passes over memory and k - 1 throwaway allocations.
+ *
+ * Expression templates fix this by making `a + b` return a lightweight *description* of the
+ * computation instead of the result:
+ * - `Vec` owns the data and is the only type that allocates.
+ * - `BinaryExpr<L, R, Op>` stores its two operands and an operation; its `operator[]` computes a
+ *   single element on demand.
+ * - The whole chain `a + b * c - d` becomes a compile-time tree of nested `BinaryExpr` types.
+ * - Assigning the tree to a `Vec` runs ONE loop that evaluates every element of the tree, so each
+ *   input is read once and the output is written once. The loop body is plain arithmetic, which
+ *   the compiler can inline and vectorize.
+ *
+ * The benchmark in main() compares eager evaluation against the fused expression for chains of
+ * 2 to 8 additions and reports time and the estimated bytes moved through memory.
+ *
+ * @note Leaves (`Vec`) are held by const reference and interior nodes by value. An expression must
+ *       therefore not outlive the vectors it refers to; assign it to a `Vec` before they go away.
+ * @note Compile with optimization (e.g. `-O2`) so the expression tree is fully inlined.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Base class for every expression (CRTP). Gives operators a single type to match on.
+template <typename E>
+struct VecExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+    double operator[](std::size_t i) const { return self()[i]; }
+    std::size_t size() const { return self().size(); }
+};
+
+// Owning vector. Assigning an expression to it evaluates the whole tree in one loop.
+class Vec : public VecExpr<Vec> {
+public:
+    Vec() = default;
+    explicit Vec(std::size_t n, double value = 0.0) : data_(n, value) {}
+
+    // Construct directly from an expression: one allocation, one fused loop.
+    template <typename E>
+    Vec(const VecExpr<E>& expr) : data_(expr.size()) {
+        assign(expr.self());
+    }
+
+    template <typename E>
+    Vec& operator=(const VecExpr<E>& expr) {
+        data_.resize(expr.size());
+        assign(expr.self());
+        return *this;
+    }
+
+    double operator[](std::size_t i) const { return data_[i]; }
+    double& operator[](std::size_t i) { return data_[i]; }
+    std::size_t size() const { return data_.size(); }
+
+private:
+    // The fused loop. `expr[i]` is inlined down to the leaf loads, so this is as tight as a
+    // hand-written loop over all operands.
+    template <typename E>
+    void assign(const E& expr) {
+        double* out = data_.data();
+        const std::size_t n = data_.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = expr[i];
+        }
+    }
+
+    std::vector<double> data_;
+};
+
+// Leaves are stored by reference (no copy of the data), interior nodes by value (they are tiny).
+template <typename E>
+using ExprStorage = std::conditional_t<std::is_same_v<E, Vec>, const Vec&, const E>;
+
+// A node of the expression tree: combines two sub-expressions elementwise with Op.
+template <typename L, typename R, typename Op>
+class BinaryExpr : public VecExpr<BinaryExpr<L, R, Op>> {
+public:
+    BinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+    double operator[](std::size_t i) const { return Op::apply(lhs_[i], rhs_[i]); }
+    std::size_t size() const { return lhs_.size(); }
+
+private:
+    ExprStorage<L> lhs_;
+    ExprStorage<R> rhs_;
+};
+
+struct AddOp { static double apply(double a, double b) { return a + b; } };
+struct SubOp { static double apply(double a, double b) { return a - b; } };
+struct MulOp { static double apply(double a, double b) { return a * b; } };
+
+// Operators build tree nodes; nothing is computed here.
+template <typename L, typename R>
+BinaryExpr<L, R, AddOp> operator+(const VecExpr<L>& lhs, const VecExpr<R>& rhs) {
+    return BinaryExpr<L, R, AddOp>(lhs.self(), rhs.self());
+}
+
+template <typename L, typename R>
+BinaryExpr<L, R, SubOp> operator-(const VecExpr<L>& lhs, const VecExpr<R>& rhs) {
+    return BinaryExpr<L, R, SubOp>(lhs.self(), rhs.self());
+}
+
+template <typename L, typename R>
+BinaryExpr<L, R, MulOp> operator*(const VecExpr<L>& lhs, const VecExpr<R>& rhs) {
+    return BinaryExpr<L, R, MulOp>(lhs.self(), rhs.self());
+}
+
+// Eager counterpart of add<T> from 16_functions.cpp, applied to whole vectors.
+// Every call allocates and fills a brand new result vector.
+std::vector<double> add(const std::vector<double>& a, const std::vector<double>& b) {
+    std::vector<double> result(a.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        result[i] = a[i] + b[i];
+    }
+    return result;
+}
+
+// Builds `v[0] + v[1] + ... + v[Ops]` as one expression tree (fold over the index pack).
+template <std::size_t... I>
+Vec fusedChain(const std::vector<Vec>& v, std::index_sequence<I...>) {
+    return Vec((v[I] + ...));
+}
+
+// Evaluates the same chain eagerly: add(add(add(v0, v1), v2), ...).
+std::vector<double> eagerChain(const std::vector<std::vector<double>>& v, std::size_t ops) {
+    std::vector<double> acc = add(v[0], v[1]);
+    for (std::size_t k = 2; k <= ops; ++k) {
+        acc = add(acc, v[k]);
+    }
+    return acc;
+}
+
+// Times `fn` over `reps` repetitions and returns the best run in milliseconds.
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+template <std::size_t Ops>
+void benchmarkChain(const std::vector<Vec>& lazyIn, const std::vector<std::vector<double>>& eagerIn) {
+    const std::size_t n = lazyIn[0].size();
+    const double mb = static_cast<double>(n * sizeof(double)) / (1024.0 * 1024.0);
+    double checksum = 0.0;
+
+    double eagerMs = bestOfMs(5, [&] {
+        std::vector<double> r = eagerChain(eagerIn, Ops);
+        checksum += r[n / 2];
+    });
+    double fusedMs = bestOfMs(5, [&] {
+        Vec r = fusedChain(lazyIn, std::make_index_sequence<Ops + 1>{});
+        checksum += r[n / 2];
+    });
+
+    // Eager: every add reads two arrays and writes one. Fused: read each input once, write once.
+    double eagerMb = 3.0 * Ops * mb;
+    double fusedMb = (Ops + 2.0) * mb;
+
+    std::cout << "  ops=" << Ops
+              << "  eager: " << eagerMs << " ms, ~" << eagerMb << " MB"
+              << "  | fused: " << fusedMs << " ms, ~" << fusedMb << " MB"
+              << "  | speedup x" << eagerMs / fusedMs
+              << "  (check " << checksum << ")" << std::endl;
+}
+
+template <std::size_t... Ops>
+void benchmarkChains(const std::vector<Vec>& lazyIn, const std::vector<std::vector<double>>& eagerIn,
+                     std::index_sequence<Ops...>) {
+    (benchmarkChain<Ops + 2>(lazyIn, eagerIn), ...);
+}
+
+int main() {
+    // Small demonstration: the result is computed in one pass when assigned to `d`.
+    Vec a(5, 1.0), b(5, 2.0), c(5, 3.0);
+    Vec d = a + b * c - a;
+    std::cout << "a + b * c - a = ";
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        std::cout << d[i] << " ";
+    }
+    std::cout << std::endl;
+
+    // Benchmark: 9 input vectors of 4M doubles (32 MB each), well beyond any cache.
+    const std::size_t n = std::size_t{1} << 22;
+    std::vector<Vec> lazyIn;
+    std::vector<std::vector<double>> eagerIn;
+    for (int k = 0; k < 9; ++k) {
+        lazyIn.emplace_back(n, 1.0 + k);
+        eagerIn.emplace_back(n, 1.0 + k);
+    }
+
+    std::cout << "Chained additions over " << n << " doubles (best of 5):" << std::endl;
+    benchmarkChains(lazyIn, eagerIn, std::make_index_sequence<7>{});
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Why eager evaluation is slow for containers:
+ *    - add(add(a, b), c) materializes add(a, b) into a temporary before the outer add runs.
+ *    - Each extra operation costs an allocation plus a full read/write pass over memory, so large
+ *      vectors become memory-bandwidth bound long before the arithmetic matters.
+ *
+ * 2. How expression templates help:
+ *    - Operators return small objects whose TYPE encodes the whole computation, e.g.
+ *      BinaryExpr<BinaryExpr<Vec, Vec, AddOp>, Vec, AddOp> for (a + b) + c.
+ *    - The loop in Vec::assign() asks the root node for element i, which recursively asks its
+ *      children, all inlined at compile time into `out[i] = a[i] + b[i] + c[i]`.
+ *
+ * Tips and Tricks:
+ * - Never store an expression in an `auto` variable that outlives its operands: the leaves are
+ *   references, so the expression dangles once the vectors are destroyed.
+ * - Expression templates shine for long chains on large data; for two small operands the plain
+ *   eager function is just as fast and far simpler.
+ */
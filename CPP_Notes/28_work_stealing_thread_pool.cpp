@@ -0,0 +1,626 @@
+/**
+ * @file 28_work_stealing_thread_pool.cpp
+ * @brief Demonstrates a work-stealing thread pool that runs executeFunction-style callables across all cores.
+ *
+ * `executeFunction` in 16_functions.cpp runs its callable immediately on the calling thread. When a
+ * program produces millions of small callables of uneven size, it is far better to hand them to a
+ * pool of worker threads. This file builds such a pool step by step:
+ *
+ * - **Chase-Lev deque**: every worker owns a lock-free double-ended queue. The owner pushes and pops
+ *   at the bottom (LIFO, cache friendly), other workers steal from the top (FIFO, oldest and usually
+ *   biggest work first). Only a steal that races with the owner for the last item needs a CAS.
+ * - **Injection queue**: callables submitted from threads outside the pool go into one small locked
+ *   queue; workers drain it when their own deque is empty. Only tasks submitted by a worker (i.e.
+ *   from inside another task) go into the lock-free deques, so fine-grained work should be spawned
+ *   from a root task rather than submitted one by one from main().
+ * - **Futures**: `submit()` wraps the callable in a `std::packaged_task` and returns its `std::future`.
+ * - **parallel_for**: splits an index range lazily. Called from outside the pool, it injects ONE root
+ *   task; the worker that runs it splits into its own deque. A worker only splits off half of its
+ *   range while its own deque is nearly empty, so the grain adapts to how hungry the other workers
+ *   are instead of being fixed up front.
+ * - **Parking**: idle workers spin briefly, then sleep on a futex (Linux) or `std::atomic::wait`
+ *   elsewhere, so an idle pool uses no CPU. Submitters only issue a wake-up syscall when a worker is
+ *   actually asleep.
+ *
+ * The benchmark in main() compares the pool against `std::async` and a classic pool with a single
+ * mutex-protected queue on fine-grained, uneven task loads, once with every task submitted from
+ * main() (which measures the injection queue) and once spawned by a root task on a worker (which
+ * measures the Chase-Lev deques).
+ *
+ * @note Compile with `-O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Sleep while *addr == expected. Uses the futex syscall directly on Linux.
+void parkWait(std::atomic<std::uint32_t>& addr, std::uint32_t expected) {
+#ifdef __linux__
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    addr.wait(expected);
+#endif
+}
+
+// Wake up to `count` threads sleeping in parkWait on addr.
+void parkWake(std::atomic<std::uint32_t>& addr, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    if (count == 1) {
+        addr.notify_one();
+    } else {
+        addr.notify_all();
+    }
+#endif
+}
+
+// Type-erased unit of work stored in the deques. run() must not throw: it runs on a worker thread,
+// where an escaping exception would call std::terminate. submit() and parallel_for() capture
+// exceptions and rethrow them on the thread that waits for the result.
+struct Task {
+    virtual ~Task() = default;
+    virtual void run() = 0;
+};
+
+template <typename F>
+struct FunctionTask : Task {
+    explicit FunctionTask(F f) : fn(std::move(f)) {}
+    void run() override { fn(); }
+    F fn;
+};
+
+template <typename F>
+Task* makeTask(F&& f) {
+    return new FunctionTask<std::decay_t<F>>(std::forward<F>(f));
+}
+
+/**
+ * @brief Chase-Lev work-stealing deque (Lê, Pop, Cohen, Zappa Nardelli, PPoPP 2013 formulation).
+ *
+ * push()/pop() may only be called by the owning worker; steal() may be called by any thread.
+ * The ring buffer grows when full. Old buffers are kept until the deque is destroyed because a
+ * concurrent thief may still be reading from them.
+ */
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::int64_t capacity = 1024) {
+        buffers_.push_back(std::make_unique<Ring>(capacity));
+        ring_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    void push(Task* task) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (b - t > ring->capacity - 1) {
+            ring = grow(ring, t, b);
+        }
+        ring->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    Task* pop() {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            // Deque was already empty.
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Task* task = ring->get(b);
+        if (t == b) {
+            // Last element: race against thieves for it.
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    Task* steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Ring* ring = ring_.load(std::memory_order_acquire);
+        Task* task = ring->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr; // Lost the race to the owner or another thief.
+        }
+        return task;
+    }
+
+    // Approximate number of queued tasks; only meaningful as a hint.
+    std::int64_t sizeHint() const {
+        return bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Ring {
+        explicit Ring(std::int64_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<Task*>[cap]) {}
+        Task* get(std::int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, Task* task) { slots[i & mask].store(task, std::memory_order_relaxed); }
+
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<Task*>[]> slots;
+    };
+
+    Ring* grow(Ring* old, std::int64_t top, std::int64_t bottom) {
+        buffers_.push_back(std::make_unique<Ring>(old->capacity * 2));
+        Ring* bigger = buffers_.back().get();
+        for (std::int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        ring_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<Ring*> ring_{nullptr};
+    std::vector<std::unique_ptr<Ring>> buffers_; // Owner-only.
+};
+
+/**
+ * @brief Work-stealing thread pool with futures, parallel_for and futex parking.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+        : deques_(threads) {
+        for (auto& d : deques_) {
+            d = std::make_unique<WorkStealingDeque>();
+        }
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        stop_.store(true);
+        epoch_.fetch_add(1);
+        parkWake(epoch_, static_cast<int>(workers_.size()));
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs `f` on the pool and returns a future for its result.
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        std::packaged_task<R()> job(std::forward<F>(f));
+        std::future<R> result = job.get_future();
+        spawn(makeTask(std::move(job)));
+        return result;
+    }
+
+    // Calls body(i) for every i in [begin, end), splitting the range lazily across workers. If a
+    // body throws, the remaining iterations are skipped and the first exception is rethrown here.
+    template <typename Body>
+    void parallel_for(std::size_t begin, std::size_t end, Body&& body, std::size_t minGrain = 1) {
+        if (begin >= end) {
+            return;
+        }
+        std::atomic<std::size_t> pending{1};
+        ForState<std::remove_reference_t<Body>> state{this, &body, &pending, std::max<std::size_t>(1, minGrain),
+                                                      {false}, nullptr};
+        if (currentPool_ == this) {
+            runRange(&state, begin, end);
+            pending.fetch_sub(1, std::memory_order_release);
+            helpUntil([&] { return pending.load(std::memory_order_acquire) == 0; });
+        } else {
+            // From an outside thread: hand the whole range to a worker, which splits it into its own
+            // deque. The caller does not help: it has no deque, so any range it took would run
+            // unsplit while the workers starve.
+            spawn(makeTask([&state, begin, end] {
+                runRange(&state, begin, end);
+                state.pending->fetch_sub(1, std::memory_order_release);
+            }));
+            while (pending.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+        if (state.error) {
+            std::rethrow_exception(state.error); // Written before the last pending decrement.
+        }
+    }
+
+    // Runs queued tasks on the calling thread until `done()` holds. Safe to call from workers.
+    template <typename Pred>
+    void helpUntil(Pred done) {
+        while (!done()) {
+            if (!runOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    template <typename Body>
+    struct ForState {
+        ThreadPool* pool;
+        Body* body;
+        std::atomic<std::size_t>* pending;
+        std::size_t minGrain;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error; // Written once, by whoever sets `failed` first.
+    };
+
+    // Lazy binary splitting: only give work away while our own deque is nearly empty.
+    template <typename Body>
+    static void runRange(ForState<Body>* s, std::size_t lo, std::size_t hi) {
+        while (hi - lo > s->minGrain && s->pool->ownQueueLow() && !s->failed.load(std::memory_order_relaxed)) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            s->pending->fetch_add(1, std::memory_order_relaxed);
+            s->pool->spawn(makeTask([s, mid, hi] {
+                runRange(s, mid, hi);
+                s->pending->fetch_sub(1, std::memory_order_release);
+            }));
+            hi = mid;
+        }
+        try {
+            for (std::size_t i = lo; i < hi && !s->failed.load(std::memory_order_relaxed); ++i) {
+                (*s->body)(i);
+            }
+        } catch (...) {
+            if (!s->failed.exchange(true)) {
+                s->error = std::current_exception();
+            }
+        }
+    }
+
+    // Ranges are only split on workers; a split on any other thread would go to the locked queue.
+    bool ownQueueLow() const {
+        return currentPool_ == this && deques_[currentIndex_]->sizeHint() < 2;
+    }
+
+    void spawn(Task* task) {
+        if (currentPool_ == this) {
+            deques_[currentIndex_]->push(task);
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex_);
+            inject_.push_back(task);
+        }
+        // Pairs with the seq_cst increment of sleepers_ in workerLoop so a wake-up is never lost.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            parkWake(epoch_, 1);
+        }
+    }
+
+    Task* findTask() {
+        if (currentPool_ == this) {
+            if (Task* t = deques_[currentIndex_]->pop()) {
+                return t;
+            }
+        }
+        {
+            std::unique_lock<std::mutex> lock(injectMutex_, std::try_to_lock);
+            if (lock.owns_lock() && !inject_.empty()) {
+                Task* t = inject_.front();
+                inject_.pop_front();
+                return t;
+            }
+        }
+        // Try every other deque once, starting at a random victim.
+        const std::size_t n = deques_.size();
+        std::size_t start = nextRandom() % n;
+        for (std::size_t k = 0; k < n; ++k) {
+            std::size_t victim = (start + k) % n;
+            if (currentPool_ == this && victim == currentIndex_) {
+                continue;
+            }
+            if (Task* t = deques_[victim]->steal()) {
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    bool runOne() {
+        Task* t = findTask();
+        if (!t) {
+            return false;
+        }
+        t->run();
+        delete t;
+        return true;
+    }
+
+    void workerLoop(unsigned index) {
+        currentPool_ = this;
+        currentIndex_ = index;
+        int idleRounds = 0;
+        while (true) {
+            if (runOne()) {
+                idleRounds = 0;
+                continue;
+            }
+            if (++idleRounds < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Park: announce ourselves as a sleeper, re-check for work, then sleep on the futex.
+            std::uint32_t seen = epoch_.load(std::memory_order_acquire);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            if (stop_.load()) {
+                sleepers_.fetch_sub(1);
+                if (!runOne()) {
+                    break;
+                }
+                continue;
+            }
+            if (Task* t = findTask()) {
+                sleepers_.fetch_sub(1);
+                t->run();
+                delete t;
+                idleRounds = 0;
+                continue;
+            }
+            parkWait(epoch_, seen);
+            sleepers_.fetch_sub(1);
+            idleRounds = 0;
+        }
+        currentPool_ = nullptr;
+    }
+
+    static std::uint64_t nextRandom() {
+        thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    static thread_local ThreadPool* currentPool_;
+    static thread_local std::size_t currentIndex_;
+
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+    std::vector<std::thread> workers_;
+    std::mutex injectMutex_;
+    std::deque<Task*> inject_;
+    std::atomic<bool> stop_{false};
+    alignas(64) std::atomic<std::uint32_t> epoch_{0};
+    alignas(64) std::atomic<int> sleepers_{0};
+};
+
+thread_local ThreadPool* ThreadPool::currentPool_ = nullptr;
+thread_local std::size_t ThreadPool::currentIndex_ = 0;
+
+// Baseline: the textbook pool with one mutex-protected queue shared by all workers.
+class LockedQueuePool {
+public:
+    explicit LockedQueuePool(unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                        if (stop_ && jobs_.empty()) {
+                            return;
+                        }
+                        job = std::move(jobs_.front());
+                        jobs_.pop_front();
+                    }
+                    job();
+                }
+            });
+        }
+    }
+
+    ~LockedQueuePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto job = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.emplace_back([job] { (*job)(); });
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stop_ = false;
+};
+
+// Pool-backed counterpart of executeFunction from 16_functions.cpp.
+std::future<void> executeFunction(ThreadPool& pool, const std::function<void()>& func) {
+    return pool.submit(func);
+}
+
+// A small task whose cost varies with i (between a few and a few hundred nanoseconds).
+std::uint64_t unevenWork(std::size_t i) {
+    std::uint64_t x = i * 2654435761u + 1;
+    std::size_t rounds = (i % 64) * 4;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+template <typename Submit>
+double benchmarkFutures(std::size_t tasks, Submit submit, std::uint64_t& checksum) {
+    return timeMs([&] {
+        std::vector<std::future<std::uint64_t>> results;
+        results.reserve(tasks);
+        for (std::size_t i = 0; i < tasks; ++i) {
+            results.push_back(submit([i] { return unevenWork(i); }));
+        }
+        for (auto& r : results) {
+            checksum += r.get();
+        }
+    });
+}
+
+// Same tasks, but submitted by one root task running on the pool. In the work-stealing pool they
+// go into that worker's deque and idle workers steal them; the locked pool still uses its queue.
+template <typename Pool>
+double benchmarkSpawnedFutures(Pool& pool, std::size_t tasks, std::uint64_t& checksum) {
+    return timeMs([&] {
+        std::vector<std::future<std::uint64_t>> results(tasks);
+        pool.submit([&] {
+            for (std::size_t i = 0; i < tasks; ++i) {
+                results[i] = pool.submit([i] { return unevenWork(i); });
+            }
+        }).get();
+        for (auto& r : results) {
+            checksum += r.get();
+        }
+    });
+}
+
+int main() {
+    ThreadPool pool;
+    std::cout << "Work-stealing pool with " << pool.size() << " workers" << std::endl;
+
+    // executeFunction, but on the pool.
+    executeFunction(pool, [] { std::cout << "Lambda function executed on the pool!" << std::endl; }).get();
+
+    std::future<int> answer = pool.submit([] { return 6 * 7; });
+    std::cout << "Future result: " << answer.get() << std::endl;
+
+    // Fine-grained futures: work-stealing pool vs single locked queue vs std::async.
+    const std::size_t tasks = 100000;
+    std::uint64_t checksum = 0;
+    double wsMs = benchmarkFutures(tasks, [&](auto f) { return pool.submit(std::move(f)); }, checksum);
+    double wsSpawnMs = benchmarkSpawnedFutures(pool, tasks, checksum);
+
+    double lockedMs = 0.0, lockedSpawnMs = 0.0;
+    {
+        LockedQueuePool locked;
+        lockedMs = benchmarkFutures(tasks, [&](auto f) { return locked.submit(std::move(f)); }, checksum);
+        lockedSpawnMs = benchmarkSpawnedFutures(locked, tasks, checksum);
+    }
+
+    // std::async(launch::async) starts a thread per call, so use a tenth of the tasks and scale up.
+    const std::size_t asyncTasks = tasks / 10;
+    double asyncMs = benchmarkFutures(asyncTasks, [](auto f) { return std::async(std::launch::async, std::move(f)); },
+                                      checksum) * 10.0;
+
+    auto report = [tasks](const char* label, double ms) {
+        std::cout << label << ms << " ms (" << ms * 1e6 / tasks << " ns/task)" << std::endl;
+    };
+    std::cout << tasks << " uneven tasks with futures, submitted from main (work-stealing pool: injection queue):"
+              << std::endl;
+    report("  work-stealing pool:  ", wsMs);
+    report("  single locked queue: ", lockedMs);
+    report("  std::async (scaled): ", asyncMs);
+    std::cout << "Same tasks spawned by a root task on a worker (work-stealing pool: Chase-Lev deques):"
+              << std::endl;
+    report("  work-stealing pool:  ", wsSpawnMs);
+    report("  single locked queue: ", lockedSpawnMs);
+
+    // parallel_for over very fine-grained iterations vs a serial loop.
+    const std::size_t n = 2000000;
+    std::vector<std::uint64_t> out(n);
+    double serialMs = timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = unevenWork(i);
+        }
+    });
+    double parMs = timeMs([&] { pool.parallel_for(0, n, [&](std::size_t i) { out[i] = unevenWork(i); }, 256); });
+    for (std::size_t i = 0; i < n; i += 4096) {
+        checksum += out[i];
+    }
+
+    std::cout << "parallel_for over " << n << " iterations:" << std::endl;
+    std::cout << "  serial loop: " << serialMs << " ms" << std::endl;
+    std::cout << "  parallel_for: " << parMs << " ms (speedup x" << serialMs / parMs << ")" << std::endl;
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Why one shared queue does not scale:
+ *    - Every submit and every dequeue takes the same mutex, so with many small tasks the workers
+ *      spend their time fighting over the lock and bouncing its cache line between cores.
+ *
+ * 2. Work stealing:
+ *    - Each worker pushes new tasks onto its own deque and pops them back in LIFO order, touching
+ *      only its own cache lines. Only idle workers reach into someone else's deque.
+ *    - Thieves take the OLDEST task, which in recursive splitting is the biggest chunk of work, so
+ *      a single steal keeps a thief busy for a long time.
+ *
+ * 3. Parking:
+ *    - A worker that found nothing for a while registers as a sleeper and waits on a futex word.
+ *    - Submitters check the sleeper count after publishing the task and only then pay for a wake-up.
+ *
+ * 4. Where tasks come from matters:
+ *    - main() is not a worker, so everything it submits goes through the locked injection queue,
+ *      just like the baseline pool. The deques only help when tasks are created by tasks: a root
+ *      task that spawns the rest, recursive splitting, or parallel_for's range halves.
+ *
+ * Tips and Tricks:
+ * - Do not block a worker on future::get() of a task that has not started yet; use helpUntil() so
+ *   the waiting worker keeps running tasks instead of deadlocking the pool.
+ * - Tasks of a few hundred nanoseconds are fine for the deque, but each submit() with a future also
+ *   allocates shared state; batch tiny loops with parallel_for instead.
+ */
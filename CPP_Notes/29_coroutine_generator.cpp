@@ -0,0 +1,316 @@
+/**
+ * @file 29_coroutine_generator.cpp
+ * @brief Demonstrates a C++20 coroutine generator<T> that produces sequences lazily instead of materializing them.
+ *
+ * 14_loops.cpp and 13a_iota_raw_arrays.cpp always build the whole `std::vector` or array first and
+ * only then loop over it. For large sequences (ranges of numbers, filtered ranges, records read from
+ * a file) that keeps every element in memory at once, even though the loop only ever looks at one.
+ *
+ * A generator is a coroutine that `co_yield`s one value at a time. The loop pulls the next value on
+ * demand, so memory use is the size of the coroutine frame (a few dozen bytes) no matter how long
+ * the sequence is.
+ *
+ * This file shows:
+ * - `generator<T>`: a minimal coroutine return type that works with range-based for loops.
+ * - A recycling frame allocator: coroutine frames are normally heap-allocated. `promise_type`
+ *   overrides `operator new`/`operator delete` to take frames from a per-thread free list, so after
+ *   warm-up creating a generator performs no heap allocation at all.
+ * - Lazy versions of `iota`, a filter over another generator, and a line-by-line record reader.
+ * - A benchmark comparing memory and throughput against the materialize-then-loop style.
+ *
+ * @note Compile with `-std=c++20 -O2`.
+ */
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Per-thread free list of coroutine frames, bucketed by size in 64-byte steps.
+ *
+ * Frames released by finished generators are kept and handed to the next generator of a similar
+ * size, so the steady state performs no calls to the global allocator.
+ */
+class FrameRecycler {
+public:
+    static void* allocate(std::size_t size) {
+        std::size_t bucket = bucketFor(size);
+        if (bucket < kBuckets && lists()[bucket] != nullptr) {
+            FreeBlock* block = lists()[bucket];
+            lists()[bucket] = block->next;
+            ++stats().reused;
+            return block;
+        }
+        ++stats().fresh;
+        return ::operator new(bucket < kBuckets ? (bucket + 1) * kGranule : size);
+    }
+
+    static void deallocate(void* ptr, std::size_t size) {
+        std::size_t bucket = bucketFor(size);
+        if (bucket < kBuckets) {
+            FreeBlock* block = static_cast<FreeBlock*>(ptr);
+            block->next = lists()[bucket];
+            lists()[bucket] = block;
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+    struct Stats {
+        std::size_t fresh = 0;  // Frames obtained from the global heap.
+        std::size_t reused = 0; // Frames served from the free list.
+    };
+
+    static Stats& stats() {
+        thread_local Stats s;
+        return s;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t kGranule = 64;
+    static constexpr std::size_t kBuckets = 16; // Frames up to 1 KiB are recycled.
+
+    static std::size_t bucketFor(std::size_t size) { return (size - 1) / kGranule; }
+
+    // The lists own their blocks for the lifetime of the thread.
+    struct Lists {
+        FreeBlock* heads[kBuckets] = {};
+        FreeBlock*& operator[](std::size_t i) { return heads[i]; }
+        ~Lists() {
+            for (FreeBlock* head : heads) {
+                while (head) {
+                    FreeBlock* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    static Lists& lists() {
+        thread_local Lists l;
+        return l;
+    }
+};
+
+/**
+ * @brief Lazy sequence of T produced by a coroutine; usable in range-based for loops.
+ */
+template <typename T>
+class generator {
+public:
+    struct promise_type {
+        const T* current = nullptr;
+        std::exception_ptr error;
+
+        generator get_return_object() {
+            return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        // The yielded value lives in the coroutine frame while it is suspended, so storing its
+        // address is enough; no copy is made.
+        std::suspend_always yield_value(const T& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { error = std::current_exception(); }
+
+        static void* operator new(std::size_t size) { return FrameRecycler::allocate(size); }
+        static void operator delete(void* ptr, std::size_t size) { FrameRecycler::deallocate(ptr, size); }
+    };
+
+    class iterator {
+    public:
+        explicit iterator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        const T& operator*() const { return *handle_.promise().current; }
+        iterator& operator++() {
+            handle_.resume();
+            rethrowIfFailed();
+            return *this;
+        }
+        bool operator==(std::default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+        void rethrowIfFailed() const {
+            if (handle_.done() && handle_.promise().error) {
+                std::rethrow_exception(handle_.promise().error);
+            }
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    generator(generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    generator& operator=(generator&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    generator(const generator&) = delete;
+    generator& operator=(const generator&) = delete;
+    ~generator() { destroy(); }
+
+    iterator begin() {
+        handle_.resume(); // Run up to the first co_yield.
+        iterator it(handle_);
+        it.rethrowIfFailed();
+        return it;
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    explicit generator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    void destroy() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Lazy counterpart of std::iota: yields first, first + 1, ..., last - 1.
+generator<int> iota(int first, int last) {
+    for (int i = first; i < last; ++i) {
+        co_yield i;
+    }
+}
+
+// Lazy filter: yields only the values of `source` that satisfy `pred`.
+template <typename T, typename Pred>
+generator<T> filter(generator<T> source, Pred pred) {
+    for (const T& value : source) {
+        if (pred(value)) {
+            co_yield value;
+        }
+    }
+}
+
+// Yields one record (line) at a time from a stream instead of loading the whole file.
+generator<std::string> readRecords(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        co_yield line;
+    }
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+    // The same output as 13a_iota_raw_arrays.cpp, but no array is ever built.
+    std::cout << "Lazy iota: ";
+    for (int value : iota(0, 10)) {
+        std::cout << value << " ";
+    }
+    std::cout << std::endl;
+
+    // Generators compose: only odd numbers from the lazy range.
+    std::cout << "Odd numbers: ";
+    for (int value : filter(iota(0, 10), [](int v) { return v % 2 != 0; })) {
+        std::cout << value << " ";
+    }
+    std::cout << std::endl;
+
+    std::istringstream file("id=1,name=alpha\nid=2,name=beta\nid=3,name=gamma\n");
+    std::cout << "Records:" << std::endl;
+    for (const std::string& record : readRecords(file)) {
+        std::cout << "  " << record << std::endl;
+    }
+
+    // Benchmark: sum the even numbers of [0, n) in both styles.
+    const int n = 20000000;
+    long long materializedSum = 0;
+    long long lazySum = 0;
+
+    double materializedMs = timeMs([&] {
+        std::vector<int> all(n);
+        std::iota(all.begin(), all.end(), 0);
+        std::vector<int> evens;
+        for (int v : all) {
+            if (v % 2 == 0) {
+                evens.push_back(v);
+            }
+        }
+        for (int v : evens) {
+            materializedSum += v;
+        }
+    });
+    double lazyMs = timeMs([&] {
+        for (int v : filter(iota(0, n), [](int x) { return x % 2 == 0; })) {
+            lazySum += v;
+        }
+    });
+
+    // Creating many short-lived generators shows the recycling allocator at work.
+    FrameRecycler::Stats before = FrameRecycler::stats();
+    long long smallSum = 0;
+    double manyMs = timeMs([&] {
+        for (int k = 0; k < 100000; ++k) {
+            for (int v : iota(0, 8)) {
+                smallSum += v;
+            }
+        }
+    });
+    FrameRecycler::Stats after = FrameRecycler::stats();
+
+    std::size_t vectorBytes = n * sizeof(int) + (n / 2) * sizeof(int); // all + evens (lower bound)
+    std::cout << "Sum of evens below " << n << ":" << std::endl;
+    std::cout << "  materialize then loop: " << materializedMs << " ms, >= " << vectorBytes / (1024 * 1024)
+              << " MB of vectors (sum " << materializedSum << ")" << std::endl;
+    std::cout << "  lazy generators:       " << lazyMs << " ms, two coroutine frames (sum " << lazySum << ")"
+              << std::endl;
+    std::cout << "100000 short generators: " << manyMs << " ms, heap frames: " << after.fresh - before.fresh
+              << ", recycled frames: " << after.reused - before.reused << " (sum " << smallSum << ")" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. How the generator works:
+ *    - Calling iota(0, 10) only creates the coroutine frame and suspends immediately
+ *      (initial_suspend returns suspend_always).
+ *    - begin() resumes it until the first co_yield; operator++ resumes it until the next one.
+ *    - When the coroutine body finishes, handle.done() becomes true and the loop ends.
+ *
+ * 2. Where the memory goes:
+ *    - The materialized version holds n ints plus the filtered copy at the same time.
+ *    - The lazy version holds only the local variables of each coroutine (its frame).
+ *
+ * 3. Recycling frames:
+ *    - The compiler calls promise_type::operator new for each frame. Returning blocks from a free
+ *      list instead of the global heap makes generator creation as cheap as popping a pointer.
+ *
+ * Tips and Tricks:
+ * - A generator can be iterated only once; call the coroutine again to restart the sequence.
+ * - Parameters are copied into the frame, but references are not: do not pass temporaries by
+ *   reference to a generator that outlives the full expression (readRecords takes a stream that
+ *   must stay alive while iterating).
+ * - Materialize when you need random access or several passes; generate lazily when you need one pass.
+ */
@@ -0,0 +1,455 @@
+/**
+ * @file 30_range_pipeline.cpp
+ * @brief Demonstrates a fused, push-based pipeline (source | filter | transform | take_while | sink).
+ *
+ * 15_continue_and_break.cpp shows the two building blocks of filtering code: `continue` to skip an
+ * element (skip the even numbers) and `break` to stop early (stop at 5). Composing several such
+ * steps by hand usually ends up as several loops with an intermediate vector between each pair.
+ *
+ * This file builds a tiny pipeline library in which every stage is a small callable object:
+ * - `filter(pred)` is a `continue`: the element is simply not passed on.
+ * - `transform(fn)` changes the element and passes it on.
+ * - `take_while(pred)` is a `break`: it tells the source to stop producing.
+ * - A sink (`sum()`, `to_vector()`, `for_each(fn)`) consumes what reaches the end.
+ *
+ * `operator|` nests the stages at compile time. The source then runs ONE loop and pushes each element
+ * through the inlined chain of stages, so there is no intermediate storage and no extra pass.
+ *
+ * A batch mode (`source.batched(chunk)`) hands contiguous blocks to stages instead of single
+ * elements. A `transform` in front of `sum` is folded into the sum's block loop, so the chain runs
+ * as one indexed loop with no staging buffer; `filter` and `take_while` fall back to the element
+ * path for that block. The element path of a chain without `filter` or `take_while` already inlines
+ * to the same simple loop, so batch mode does not make it faster; it guarantees the loop shape.
+ *
+ * The benchmark in main() compares the fused pipeline against the equivalent multi-pass code.
+ *
+ * @note Compile with `-std=c++17 -O3` (or `-O2 -ftree-vectorize`) so the block loops are vectorized.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ---------- stage descriptions (what the user writes) ----------
+
+template <typename Pred>
+struct FilterStage { Pred pred; };
+
+template <typename Fn>
+struct TransformStage { Fn fn; };
+
+template <typename Pred>
+struct TakeWhileStage { Pred pred; };
+
+template <typename Pred>
+FilterStage<Pred> filter(Pred pred) { return {pred}; }
+
+template <typename Fn>
+TransformStage<Fn> transform(Fn fn) { return {fn}; }
+
+template <typename Pred>
+TakeWhileStage<Pred> take_while(Pred pred) { return {pred}; }
+
+// ---------- sinks (end of the pipeline) ----------
+// push() returns false when the pipeline must stop (the `break` of the fused loop).
+
+struct SumSink {
+    long long total = 0;
+    bool push(long long v) { total += v; return true; }
+    template <typename T>
+    bool pushBlock(const T* data, std::size_t n) {
+        return pushBlock(data, n, [](const T& v) { return v; });
+    }
+    // Mapped block path: sums fn(data[i]) in the same loop, so an upstream transform needs no buffer.
+    template <typename T, typename Fn>
+    bool pushBlock(const T* data, std::size_t n, Fn fn) {
+        long long s = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            s += fn(data[i]);
+        }
+        total += s;
+        return true;
+    }
+    long long result() const { return total; }
+};
+
+template <typename T>
+struct VectorSink {
+    std::vector<T> out;
+    bool push(const T& v) { out.push_back(v); return true; }
+    std::vector<T> result() { return std::move(out); }
+};
+
+template <typename Fn>
+struct ForEachSink {
+    Fn fn;
+    template <typename T>
+    bool push(const T& v) { fn(v); return true; }
+    void result() const {}
+};
+
+struct SumTag {};
+template <typename T> struct ToVectorTag {};
+template <typename Fn> struct ForEachTag { Fn fn; };
+
+inline SumTag sum() { return {}; }
+template <typename T> ToVectorTag<T> to_vector() { return {}; }
+template <typename Fn> ForEachTag<Fn> for_each(Fn fn) { return {fn}; }
+
+inline SumSink makeSink(SumTag) { return {}; }
+template <typename T> VectorSink<T> makeSink(ToVectorTag<T>) { return {}; }
+template <typename Fn> ForEachSink<Fn> makeSink(ForEachTag<Fn> tag) { return {tag.fn}; }
+
+// ---------- stage implementations (what the fused loop calls) ----------
+
+// Uses the downstream block path when it has one, else pushes element by element.
+template <typename Node, typename T, typename = void>
+struct HasBlockPath : std::false_type {};
+template <typename Node, typename T>
+struct HasBlockPath<Node, T, std::void_t<decltype(std::declval<Node&>().pushBlock(std::declval<const T*>(), 0))>>
+    : std::true_type {};
+
+// Whether the node can apply a transform inside its own block loop: pushBlock(data, n, fn).
+template <typename Node, typename T, typename Fn, typename = void>
+struct HasMappedBlockPath : std::false_type {};
+template <typename Node, typename T, typename Fn>
+struct HasMappedBlockPath<
+    Node, T, Fn,
+    std::void_t<decltype(std::declval<Node&>().pushBlock(std::declval<const T*>(), 0, std::declval<Fn>()))>>
+    : std::true_type {};
+
+template <typename Node, typename T>
+bool forwardBlock(Node& node, const T* data, std::size_t n) {
+    if constexpr (HasBlockPath<Node, T>::value) {
+        return node.pushBlock(data, n);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!node.push(data[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+template <typename Pred, typename Next>
+struct FilterNode {
+    Pred pred;
+    Next next;
+    template <typename T>
+    bool push(const T& v) { return pred(v) ? next.push(v) : true; } // `continue`
+    template <typename T>
+    bool pushBlock(const T* data, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!push(data[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <typename Fn, typename Next>
+struct TransformNode {
+    Fn fn;
+    Next next;
+    template <typename T>
+    bool push(const T& v) { return next.push(fn(v)); }
+
+    template <typename T>
+    bool pushBlock(const T* data, std::size_t n) {
+        return pushBlock(data, n, [](const T& v) { return v; });
+    }
+
+    // Block path with the upstream transforms g folded in. If the next node takes a mapped block,
+    // the transform runs inside its loop (transform | sum is ONE indexed loop). Otherwise the block
+    // is transformed into a small buffer and passed on.
+    template <typename T, typename G>
+    bool pushBlock(const T* data, std::size_t n, G g) {
+        auto mapped = [this, g](const T& v) { return fn(g(v)); };
+        if constexpr (HasMappedBlockPath<Next, T, decltype(mapped)>::value) {
+            return next.pushBlock(data, n, mapped);
+        } else {
+            using U = std::decay_t<decltype(mapped(*data))>;
+            U buffer[kBlock];
+            for (std::size_t done = 0; done < n; done += kBlock) {
+                std::size_t m = (n - done < kBlock) ? n - done : kBlock;
+                for (std::size_t i = 0; i < m; ++i) {
+                    buffer[i] = mapped(data[done + i]);
+                }
+                if (!forwardBlock(next, buffer, m)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    static constexpr std::size_t kBlock = 256;
+};
+
+template <typename Pred, typename Next>
+struct TakeWhileNode {
+    Pred pred;
+    Next next;
+    template <typename T>
+    bool push(const T& v) { return pred(v) ? next.push(v) : false; } // `break`
+    template <typename T>
+    bool pushBlock(const T* data, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!push(data[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Turns a stage description into its node, wrapping the rest of the pipeline.
+template <typename Pred, typename Next>
+FilterNode<Pred, Next> makeNode(const FilterStage<Pred>& s, Next next) { return {s.pred, std::move(next)}; }
+template <typename Fn, typename Next>
+TransformNode<Fn, Next> makeNode(const TransformStage<Fn>& s, Next next) { return {s.fn, std::move(next)}; }
+template <typename Pred, typename Next>
+TakeWhileNode<Pred, Next> makeNode(const TakeWhileStage<Pred>& s, Next next) { return {s.pred, std::move(next)}; }
+
+// ---------- sources and composition ----------
+
+// Stages collected so far; built left to right by operator|, instantiated right to left on sink.
+template <typename Source, typename... Stages>
+struct Pipeline {
+    Source source;
+    std::tuple<Stages...> stages;
+};
+
+// Half-open integer range [first, last), the loop counter of 15_continue_and_break.cpp.
+struct IotaSource {
+    int first;
+    int last;
+    std::size_t chunk = 0; // 0 = element mode
+
+    IotaSource batched(std::size_t blockSize) const { return {first, last, blockSize}; }
+
+    template <typename Node>
+    void run(Node& node) const {
+        if (chunk == 0) {
+            for (int i = first; i < last; ++i) {
+                if (!node.push(i)) {
+                    break;
+                }
+            }
+            return;
+        }
+        std::vector<int> block(chunk);
+        for (int base = first; base < last; base += static_cast<int>(chunk)) {
+            std::size_t m = static_cast<std::size_t>(last - base) < chunk ? static_cast<std::size_t>(last - base) : chunk;
+            std::iota(block.begin(), block.begin() + m, base);
+            if (!forwardBlock(node, block.data(), m)) {
+                break;
+            }
+        }
+    }
+};
+
+// Any contiguous container (e.g. std::vector<int>) as a source.
+template <typename T>
+struct SpanSource {
+    const T* data;
+    std::size_t size;
+    std::size_t chunk = 0;
+
+    SpanSource batched(std::size_t blockSize) const { return {data, size, blockSize}; }
+
+    template <typename Node>
+    void run(Node& node) const {
+        if (chunk == 0) {
+            for (std::size_t i = 0; i < size; ++i) {
+                if (!node.push(data[i])) {
+                    break;
+                }
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < size; i += chunk) {
+            std::size_t m = size - i < chunk ? size - i : chunk;
+            if (!forwardBlock(node, data + i, m)) {
+                break;
+            }
+        }
+    }
+};
+
+inline IotaSource iota(int first, int last) { return {first, last}; }
+
+template <typename T>
+SpanSource<T> from(const std::vector<T>& v) { return {v.data(), v.size()}; }
+
+template <typename S>
+struct IsSource : std::false_type {};
+template <> struct IsSource<IotaSource> : std::true_type {};
+template <typename T> struct IsSource<SpanSource<T>> : std::true_type {};
+
+template <typename S>
+struct IsStage : std::false_type {};
+template <typename P> struct IsStage<FilterStage<P>> : std::true_type {};
+template <typename F> struct IsStage<TransformStage<F>> : std::true_type {};
+template <typename P> struct IsStage<TakeWhileStage<P>> : std::true_type {};
+
+template <typename Source, typename Stage,
+          std::enable_if_t<IsSource<Source>::value && IsStage<Stage>::value, int> = 0>
+Pipeline<Source, Stage> operator|(Source source, Stage stage) {
+    return {source, std::make_tuple(stage)};
+}
+
+template <typename Source, typename... Stages, typename Stage, std::enable_if_t<IsStage<Stage>::value, int> = 0>
+Pipeline<Source, Stages..., Stage> operator|(Pipeline<Source, Stages...> p, Stage stage) {
+    return {p.source, std::tuple_cat(p.stages, std::make_tuple(stage))};
+}
+
+// Wraps the sink in the stages from last to first, so the first stage is the outermost node.
+template <std::size_t I, typename Tuple, typename Node>
+auto buildChain(const Tuple& stages, Node node) {
+    if constexpr (I == 0) {
+        return node;
+    } else {
+        return buildChain<I - 1>(stages, makeNode(std::get<I - 1>(stages), std::move(node)));
+    }
+}
+
+// The sink is the node without a `next` member.
+template <typename Node, typename = void>
+struct HasNext : std::false_type {};
+template <typename Node>
+struct HasNext<Node, std::void_t<decltype(std::declval<Node&>().next)>> : std::true_type {};
+
+template <typename Node>
+auto& innermostNode(Node& node) {
+    if constexpr (HasNext<Node>::value) {
+        return innermostNode(node.next);
+    } else {
+        return node;
+    }
+}
+
+template <typename Pipe, typename Tag>
+auto runPipeline(const Pipe& p, Tag tag) {
+    auto sink = makeSink(tag);
+    constexpr std::size_t n = std::tuple_size_v<std::decay_t<decltype(p.stages)>>;
+    auto chain = buildChain<n>(p.stages, std::move(sink));
+    p.source.run(chain);
+    return innermostNode(chain).result();
+}
+
+template <typename Source, typename... Stages, typename Tag,
+          std::enable_if_t<!IsStage<Tag>::value, int> = 0>
+auto operator|(const Pipeline<Source, Stages...>& p, Tag tag) {
+    return runPipeline(p, tag);
+}
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main() {
+    // 15_continue_and_break.cpp, as pipelines.
+    std::cout << "Example using take_while (break at 5):" << std::endl;
+    iota(0, 10) | take_while([](int i) { return i != 5; })
+                | for_each([](int i) { std::cout << i << " "; });
+    std::cout << std::endl;
+
+    std::cout << "Example using filter (skip evens):" << std::endl;
+    iota(0, 10) | filter([](int i) { return i % 2 != 0; })
+                | for_each([](int i) { std::cout << i << " "; });
+    std::cout << std::endl;
+
+    std::vector<int> squares = iota(0, 10) | filter([](int i) { return i % 2 != 0; })
+                                           | transform([](int i) { return i * i; })
+                                           | to_vector<int>();
+    std::cout << "Squares of odd numbers: ";
+    for (int v : squares) {
+        std::cout << v << " ";
+    }
+    std::cout << std::endl;
+
+    // Benchmark: sum of f(x) over odd x while f(x) stays below a limit, on 16M inputs.
+    const int n = 1 << 24;
+    std::vector<int> input(n);
+    std::iota(input.begin(), input.end(), 0);
+    auto isOdd = [](int x) { return (x & 1) != 0; };
+    auto scale = [](int x) { return x * 3 + 1; };
+    auto below = [](int x) { return x < (1 << 30); };
+
+    long long multi = 0, fused = 0, mapOnly = 0, mapBatched = 0;
+
+    double multiMs = bestOfMs(3, [&] {
+        std::vector<int> odds;
+        for (int x : input) {
+            if (isOdd(x)) odds.push_back(x);
+        }
+        std::vector<int> scaled;
+        for (int x : odds) scaled.push_back(scale(x));
+        std::vector<int> kept;
+        for (int x : scaled) {
+            if (!below(x)) break;
+            kept.push_back(x);
+        }
+        multi = 0;
+        for (int x : kept) multi += x;
+    });
+    double fusedMs = bestOfMs(3, [&] {
+        fused = from(input) | filter(isOdd) | transform(scale) | take_while(below) | sum();
+    });
+
+    // A map-reduce chain without control flow: both modes compile to one loop (vectorized at -O3).
+    double mapMs = bestOfMs(3, [&] { mapOnly = from(input) | transform(scale) | sum(); });
+    double batchedMs = bestOfMs(3, [&] { mapBatched = from(input).batched(4096) | transform(scale) | sum(); });
+
+    std::cout << "filter | transform | take_while | sum over " << n << " ints:" << std::endl;
+    std::cout << "  multi-pass with vectors: " << multiMs << " ms (result " << multi << ")" << std::endl;
+    std::cout << "  fused pipeline:          " << fusedMs << " ms (result " << fused << ")" << std::endl;
+    std::cout << "transform | sum:" << std::endl;
+    std::cout << "  element mode: " << mapMs << " ms (result " << mapOnly << ")" << std::endl;
+    std::cout << "  batched mode: " << batchedMs << " ms (result " << mapBatched << ")" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Push instead of pull:
+ *    - The source owns the only loop. Each stage is a node with a push(value) member that calls the
+ *      next node's push. Because every node type is known at compile time the whole chain is
+ *      inlined into the source loop, exactly like a hand-written loop with `continue` and `break`.
+ *
+ * 2. Stopping early:
+ *    - push() returns false to mean "stop". take_while returns false at the first failing element
+ *      and the source breaks out of its loop, so the rest of the input is never touched.
+ *
+ * 3. Batch mode:
+ *    - batched(chunk) makes the source hand out blocks. transform passes its function down to the
+ *      sum's block loop (pushBlock(data, n, fn)), so transform | sum is a single indexed loop;
+ *      only when the next node cannot take a mapped block is the block staged in a small buffer.
+ *    - filter and take_while process blocks element by element because their output size is data
+ *      dependent.
+ *    - For transform | sum the element mode inlines to the same loop, and the benchmark shows both
+ *      modes at the same speed: -O3 vectorizes both loops, -O2 neither. Batch mode is not a speedup
+ *      by itself; staging every block through a buffer would even make it slower.
+ *
+ * Tips and Tricks:
+ * - Keep predicates and transforms as lambdas (not std::function) so they can be inlined.
+ * - Multi-pass code is still the right choice when an intermediate result is reused several times.
+ */
@@ -0,0 +1,484 @@
+/**
+ * @file 31_async_logger.cpp
+ * @brief Demonstrates an asynchronous logger that takes std::cout off the calling thread.
+ *
+ * Every lesson so far (the `MyClass` constructors in 02_Class_Objec_Initilisation.cpp, `revealSecret`
+ * in 01_inlie_extern_friend.cpp, ...) writes straight to `std::cout` with `std::endl`. That formats
+ * the text, takes the stream lock and flushes to the OS on the calling thread. In latency-critical
+ * code that blocking I/O shows up directly in the response time.
+ *
+ * The logger in this file splits logging into two halves:
+ * - **Caller side (hot path)**: `log(format, args...)` copies a compact binary record into a
+ *   per-thread single-producer/single-consumer ring buffer. The record holds only a format id and
+ *   the raw argument values, so there is no formatting, no locking and no allocation. (The first
+ *   call of a thread to a given logger registers the thread's ring once; see localRing().)
+ * - **Background side**: one logger thread drains all rings, formats the records into a text buffer
+ *   and writes the buffer to the output stream in large batches with a single flush.
+ *
+ * If a ring is full the record is dropped and counted instead of blocking the caller.
+ *
+ * The benchmark in main() reports the caller-side p50/p99 latency of the logger against writing the
+ * same line directly to `std::cout` with `std::endl`.
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One argument of a log record: a signed or unsigned integer, a double or a string literal.
+ *
+ * Only pointers to string literals (static storage) may be logged as text, because the record is
+ * formatted later on another thread.
+ */
+struct LogArg {
+    enum class Kind : std::uint8_t { Int, UInt, Double, Literal } kind;
+    union {
+        std::int64_t i;
+        std::uint64_t u;
+        double d;
+        const char* s;
+    };
+};
+
+// Any integer or floating-point type: sizes and counters (std::size_t, unsigned) keep their
+// signedness, so a large unsigned value is not printed as a negative number.
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+inline LogArg toArg(T v) {
+    LogArg a;
+    if constexpr (std::is_floating_point_v<T>) {
+        a.kind = LogArg::Kind::Double;
+        a.d = static_cast<double>(v);
+    } else if constexpr (std::is_signed_v<T>) {
+        a.kind = LogArg::Kind::Int;
+        a.i = static_cast<std::int64_t>(v);
+    } else {
+        a.kind = LogArg::Kind::UInt;
+        a.u = static_cast<std::uint64_t>(v);
+    }
+    return a;
+}
+inline LogArg toArg(const char* v) { LogArg a; a.kind = LogArg::Kind::Literal; a.s = v; return a; }
+
+// A fixed-size binary record (56 bytes), smaller than one cache line.
+struct LogRecord {
+    static constexpr int kMaxArgs = 3;
+    std::uint16_t formatId;
+    std::uint8_t argCount;
+    LogArg args[kMaxArgs];
+};
+
+static_assert(sizeof(LogRecord) == 56, "LogRecord should stay within one cache line");
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * Head and tail live on separate cache lines so the producer and consumer do not false-share.
+ */
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool tryPush(const T& item) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ == Capacity) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ == Capacity) {
+                return false; // Full.
+            }
+        }
+        slots_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: copies up to `max` items into `out`, returns how many were taken.
+    std::size_t popBatch(T* out, std::size_t max) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        std::size_t n = std::min(head - tail, max);
+        for (std::size_t k = 0; k < n; ++k) {
+            out[k] = slots_[(tail + k) & (Capacity - 1)];
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_ = 0; // Producer's last view of tail_.
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) T slots_[Capacity];
+};
+
+/**
+ * @brief A registered format string with `{}` placeholders.
+ *
+ * Create formats once (e.g. as `static const` objects); each one gets a small integer id that is
+ * all the hot path needs to store.
+ */
+class LogFormat {
+public:
+    explicit LogFormat(const char* text);
+    std::uint16_t id() const { return id_; }
+
+private:
+    std::uint16_t id_;
+};
+
+/**
+ * @brief Asynchronous logger with per-thread SPSC rings and a background formatting thread.
+ */
+class AsyncLogger {
+public:
+    static constexpr std::size_t kRingCapacity = 8192;
+
+    explicit AsyncLogger(std::ostream& out) : out_(out), worker_([this] { run(); }) {}
+
+    ~AsyncLogger() {
+        stop_.store(true, std::memory_order_release);
+        worker_.join();
+        // Let threads that still cache one of our rings drop it on their next registration.
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        for (auto& ring : rings_) {
+            ring->loggerStopped.store(true, std::memory_order_release);
+        }
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Hot path: build the record on the stack and push it into this thread's ring.
+    template <typename... Args>
+    void log(const LogFormat& format, Args... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "too many log arguments");
+        LogRecord record;
+        record.formatId = format.id();
+        record.argCount = static_cast<std::uint8_t>(sizeof...(Args));
+        int k = 0;
+        ((record.args[k++] = toArg(args)), ...);
+        if (!localRing().tryPush(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static std::uint16_t registerFormat(const char* text) {
+        std::lock_guard<std::mutex> lock(formatsMutex());
+        formats().push_back(text);
+        return static_cast<std::uint16_t>(formats().size() - 1);
+    }
+
+    // Number of rings the background thread currently drains (one per live logging thread).
+    std::size_t ringCount() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        return rings_.size();
+    }
+
+private:
+    // A thread's ring for one logger. Shared by the thread's table and the logger's list, so
+    // whichever side finishes first cannot leave the other with a dangling pointer.
+    struct ThreadRing {
+        SpscRing<LogRecord, kRingCapacity> ring;
+        std::atomic<bool> threadExited{false};  // Set by the thread's table when the thread ends.
+        std::atomic<bool> loggerStopped{false}; // Set by ~AsyncLogger.
+    };
+
+    // The rings of one thread, keyed by logger id; threads rarely log to more than one or two
+    // loggers, so a linear scan is enough.
+    struct ThreadRings {
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<ThreadRing>>> entries;
+        ~ThreadRings() {
+            for (auto& entry : entries) {
+                entry.second->threadExited.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    // Each thread registers one ring per logger the first time it logs to it. Later calls, also
+    // after switching between loggers, only scan the thread's small table.
+    SpscRing<LogRecord, kRingCapacity>& localRing() {
+        // Keyed by a unique id rather than `this`: a new logger may reuse a dead logger's address.
+        thread_local ThreadRings table;
+        for (auto& entry : table.entries) {
+            if (entry.first == id_) {
+                return entry.second->ring;
+            }
+        }
+        return registerRing(table);
+    }
+
+    // Slow path, once per thread and logger: also forgets the rings of loggers that have stopped.
+    SpscRing<LogRecord, kRingCapacity>& registerRing(ThreadRings& table) {
+        auto& entries = table.entries;
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const auto& entry) {
+                                         return entry.second->loggerStopped.load(std::memory_order_acquire);
+                                     }),
+                      entries.end());
+        auto fresh = std::make_shared<ThreadRing>();
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings_.push_back(fresh);
+        }
+        entries.emplace_back(id_, fresh);
+        return fresh->ring;
+    }
+
+    void run() {
+        std::vector<LogRecord> batch(1024);
+        std::string text;
+        text.reserve(1 << 16);
+        while (true) {
+            bool stopping = stop_.load(std::memory_order_acquire);
+            std::vector<std::shared_ptr<ThreadRing>> rings;
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex_);
+                rings = rings_;
+            }
+            std::size_t drained = 0;
+            std::vector<std::shared_ptr<ThreadRing>> finished;
+            for (auto& ring : rings) {
+                // Read the flag BEFORE draining: every record pushed before the thread ended is
+                // then visible, so an exited thread's ring is empty after this drain.
+                bool exited = ring->threadExited.load(std::memory_order_acquire);
+                std::size_t n;
+                while ((n = ring->ring.popBatch(batch.data(), batch.size())) > 0) {
+                    for (std::size_t k = 0; k < n; ++k) {
+                        format(batch[k], text);
+                    }
+                    drained += n;
+                }
+                if (exited) {
+                    finished.push_back(ring);
+                }
+            }
+            if (!finished.empty()) {
+                // Drop the rings of threads that have exited, so thread churn does not grow rings_.
+                std::lock_guard<std::mutex> lock(ringsMutex_);
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                            [&](const std::shared_ptr<ThreadRing>& ring) {
+                                                return std::find(finished.begin(), finished.end(), ring) !=
+                                                       finished.end();
+                                            }),
+                             rings_.end());
+            }
+            if (!text.empty()) {
+                out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+                out_.flush(); // One flush per batch instead of one per line.
+                text.clear();
+            }
+            if (stopping && drained == 0) {
+                break;
+            }
+            if (drained == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+    // Expands the `{}` placeholders of the record's format with its arguments.
+    static void format(const LogRecord& record, std::string& text) {
+        const char* f;
+        {
+            std::lock_guard<std::mutex> lock(formatsMutex());
+            f = formats()[record.formatId];
+        }
+        int next = 0;
+        char number[32];
+        while (*f) {
+            if (f[0] == '{' && f[1] == '}' && next < record.argCount) {
+                const LogArg& a = record.args[next++];
+                switch (a.kind) {
+                case LogArg::Kind::Int:
+                    text.append(number, static_cast<std::size_t>(std::snprintf(number, sizeof number, "%lld", static_cast<long long>(a.i))));
+                    break;
+                case LogArg::Kind::UInt:
+                    text.append(number, static_cast<std::size_t>(std::snprintf(number, sizeof number, "%llu", static_cast<unsigned long long>(a.u))));
+                    break;
+                case LogArg::Kind::Double:
+                    text.append(number, static_cast<std::size_t>(std::snprintf(number, sizeof number, "%g", a.d)));
+                    break;
+                case LogArg::Kind::Literal:
+                    text.append(a.s);
+                    break;
+                }
+                f += 2;
+            } else {
+                text.push_back(*f++);
+            }
+        }
+        text.push_back('\n');
+    }
+
+    static std::vector<const char*>& formats() {
+        static std::vector<const char*> table;
+        return table;
+    }
+
+    static std::mutex& formatsMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    const std::uint64_t id_ = nextId();
+    std::ostream& out_;
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    std::atomic<bool> stop_{false};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::thread worker_; // Declared last: starts after every other member is initialized.
+};
+
+LogFormat::LogFormat(const char* text) : id_(AsyncLogger::registerFormat(text)) {}
+
+// Format strings used below, registered once at startup.
+static const LogFormat kParamCtor("Parameterized constructor called with value: {}");
+static const LogFormat kDefaultCtor("Default constructor called");
+static const LogFormat kSecret("The secret value is: {}");
+static const LogFormat kBench("request {} served in {} us by {}");
+static const LogFormat kRings("Rings after the worker threads exited: {}");
+
+// MyClass from 02_Class_Objec_Initilisation.cpp, logging through the async logger.
+class MyClass {
+public:
+    MyClass(AsyncLogger& logger, int value) : value(value) {
+        logger.log(kParamCtor, value);
+    }
+    explicit MyClass(AsyncLogger& logger) : value(0) {
+        logger.log(kDefaultCtor);
+    }
+
+    friend void revealSecret(AsyncLogger& logger, const MyClass& obj);
+
+private:
+    int value;
+};
+
+// revealSecret from 01_inlie_extern_friend.cpp, without blocking on std::cout.
+void revealSecret(AsyncLogger& logger, const MyClass& obj) {
+    logger.log(kSecret, obj.value);
+}
+
+// Returns the given percentile (0..100) of the sorted latencies.
+double percentile(std::vector<double>& ns, double p) {
+    std::sort(ns.begin(), ns.end());
+    std::size_t idx = static_cast<std::size_t>(p / 100.0 * static_cast<double>(ns.size() - 1));
+    return ns[idx];
+}
+
+int main() {
+    {
+        AsyncLogger logger(std::cout);
+        MyClass obj1(logger, 99);
+        MyClass obj4(logger);
+        revealSecret(logger, obj1);
+        (void)obj4;
+
+        // Short-lived threads: each registers a ring once, and the logger reclaims it after exit.
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&logger, t] { MyClass temp(logger, 100 + t); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (int wait = 0; wait < 1000 && logger.ringCount() > 1; ++wait) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        logger.log(kRings, logger.ringCount());
+    } // Destructor drains the rings and flushes before returning.
+
+    // Benchmark: both variants write to the same file through std::cout, so only the caller-side
+    // cost differs. std::cout is temporarily redirected to keep the terminal readable.
+    const int calls = 100000;
+    const char* path = "async_logger_bench.log";
+    std::ofstream file(path);
+    std::streambuf* original = std::cout.rdbuf(file.rdbuf());
+
+    std::vector<double> directNs(calls), asyncNs(calls);
+    for (int i = 0; i < calls; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        std::cout << "request " << i << " served in " << 12.5 << " us by " << "worker-1" << std::endl;
+        auto stop = std::chrono::steady_clock::now();
+        directNs[i] = std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+    std::uint64_t dropped = 0;
+    {
+        AsyncLogger logger(std::cout);
+        for (int i = 0; i < calls; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            logger.log(kBench, i, 12.5, "worker-1");
+            auto stop = std::chrono::steady_clock::now();
+            asyncNs[i] = std::chrono::duration<double, std::nano>(stop - start).count();
+            if ((i & 1023) == 0) {
+                std::this_thread::yield(); // Simulate the caller doing other work between logs.
+            }
+        }
+        dropped = logger.dropped();
+    }
+
+    std::cout.rdbuf(original);
+    file.close();
+    std::remove(path);
+
+    std::cout << "Caller-side latency over " << calls << " log calls:" << std::endl;
+    std::cout << "  std::cout + std::endl: p50 " << percentile(directNs, 50) << " ns, p99 "
+              << percentile(directNs, 99) << " ns, p99.9 " << percentile(directNs, 99.9) << " ns" << std::endl;
+    std::cout << "  async logger:          p50 " << percentile(asyncNs, 50) << " ns, p99 "
+              << percentile(asyncNs, 99) << " ns, p99.9 " << percentile(asyncNs, 99.9) << " ns"
+              << " (dropped " << dropped << ")" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. What std::cout << ... << std::endl costs the caller:
+ *    - Number and text formatting, the stream's internal locking and, because of std::endl, a flush
+ *      that ends in a write() system call for every single line.
+ *
+ * 2. What the async logger costs the caller:
+ *    - Writing 56 bytes into a ring slot and one release store. The ring belongs to the calling
+ *      thread only, so no lock or atomic read-modify-write is needed.
+ *
+ * 3. What the background thread does:
+ *    - Drains every ring in batches, formats the records into one string and writes that string with
+ *      a single flush, turning thousands of small writes into one large one.
+ *
+ * 4. Per-thread rings:
+ *    - A thread finds its ring for a logger in a small thread_local table keyed by the logger's id,
+ *      so alternating between loggers costs a short scan, not an allocation. When the thread exits,
+ *      the table's destructor marks its rings, and the background thread drops them after draining
+ *      them one last time.
+ *
+ * Tips and Tricks:
+ * - Only log string LITERALS as text arguments; a pointer to a temporary string would dangle by the
+ *   time the logger thread formats the record.
+ * - Size the rings for your burst rate. Dropping (as here) keeps latency bounded; blocking keeps
+ *   every message but puts the caller back at the mercy of I/O.
+ * - Prefer '\n' over std::endl even with plain std::cout; flushing on every line is rarely needed.
+ */
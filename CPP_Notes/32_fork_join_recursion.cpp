@@ -0,0 +1,386 @@
+/**
+ * @file 32_fork_join_recursion.cpp
+ * @brief Demonstrates fork-join parallelism for divide-and-conquer recursive functions.
+ *
+ * The `factorial` in 17_recursive_functions.cpp recurses linearly: factorial(n) needs factorial(n - 1)
+ * before it can do anything, so there is nothing to run in parallel. Many real recursive algorithms
+ * are instead *divide and conquer*: they split the problem into independent halves, solve both and
+ * combine the results (range products, tree reductions, merge sort). The two halves can run on
+ * different cores.
+ *
+ * This file provides:
+ * - `ForkJoin`: runs two callables "in parallel" with `invoke(left, right)`. It owns a fixed set of
+ *   worker threads, created once and reused by every fork. `left` is offered to the workers, `right`
+ *   runs on the current thread, and if no worker has picked `left` up by then the caller runs it
+ *   itself. An exception thrown by either half is carried back and rethrown by invoke().
+ * - `divideAndConquer(...)`: a generic recursive reduction that forks above a size cutoff and calls a
+ *   serial leaf function below it.
+ * - Built-in kernels written with it: parallel range product (factorial generalized to any range),
+ *   recursive sum and parallel merge sort (which alternates between the array and one buffer
+ *   instead of copying back after every merge).
+ * - A scaling benchmark over 1, 2, 4, ... threads.
+ *
+ * The cutoff matters: forking costs microseconds, so each leaf should do at least tens of
+ * microseconds of work. Below the cutoff the plain serial code is always faster.
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Fork-join helper with a reusable set of worker threads.
+ *
+ * `threads` is the total number of threads that may work at once (including the caller), so
+ * `threads - 1` workers are started. Forked halves wait in one shared queue; at the fork counts a
+ * cutoff allows (thousands, not millions) a single lock is not the bottleneck.
+ */
+class ForkJoin {
+public:
+    explicit ForkJoin(unsigned threads) {
+        for (unsigned i = 1; i < threads; ++i) {
+            workers_.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ForkJoin() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        changed_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ForkJoin(const ForkJoin&) = delete;
+    ForkJoin& operator=(const ForkJoin&) = delete;
+
+    // Runs left() and right() and returns when both are finished. If either throws, the
+    // exception is rethrown here after BOTH have finished (left's if both throw).
+    template <typename Left, typename Right>
+    void invoke(Left&& left, Right&& right) {
+        if (workers_.empty()) {
+            std::exception_ptr leftError;
+            try {
+                left();
+            } catch (...) {
+                leftError = std::current_exception();
+            }
+            try {
+                right();
+            } catch (...) {
+                if (!leftError) {
+                    throw;
+                }
+            }
+            if (leftError) {
+                std::rethrow_exception(leftError);
+            }
+            return;
+        }
+        Job job;
+        job.context = &left;
+        job.run = [](void* context) { (*static_cast<std::remove_reference_t<Left>*>(context))(); };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(&job);
+        }
+        changed_.notify_one();
+
+        std::exception_ptr rightError;
+        try {
+            right();
+        } catch (...) {
+            rightError = std::current_exception();
+        }
+
+        if (reclaim(&job)) {
+            execute(job); // Nobody picked it up: run it here, as plain recursion would.
+        } else {
+            helpUntilDone(job);
+        }
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+        if (rightError) {
+            std::rethrow_exception(rightError);
+        }
+    }
+
+private:
+    // A forked half. Lives on the stack of the invoke() that created it.
+    struct Job {
+        void (*run)(void*) = nullptr;
+        void* context = nullptr;
+        std::exception_ptr error;
+        bool done = false; // Guarded by mutex_.
+    };
+
+    // Takes the job back if it is still queued.
+    bool reclaim(Job* job) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(queue_.rbegin(), queue_.rend(), job); // Usually the most recent entry.
+        if (it == queue_.rend()) {
+            return false;
+        }
+        queue_.erase(std::next(it).base());
+        return true;
+    }
+
+    void execute(Job& job) {
+        try {
+            job.run(job.context);
+        } catch (...) {
+            job.error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job.done = true; // The owner may destroy the job as soon as it sees this.
+        }
+        changed_.notify_all();
+    }
+
+    // The job runs on a worker: instead of blocking, run other queued halves until it is done.
+    void helpUntilDone(Job& job) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!job.done) {
+            if (!queue_.empty()) {
+                Job* other = queue_.front();
+                queue_.pop_front();
+                lock.unlock();
+                execute(*other);
+                lock.lock();
+            } else {
+                changed_.wait(lock);
+            }
+        }
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            changed_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return; // stop_ is set and nothing is left.
+            }
+            Job* job = queue_.front(); // Oldest first: the biggest pieces of the recursion.
+            queue_.pop_front();
+            lock.unlock();
+            execute(*job);
+            lock.lock();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<Job*> queue_;
+    bool stop_ = false;
+};
+
+/**
+ * @brief Generic divide-and-conquer reduction over the index range [lo, hi).
+ *
+ * @param leaf    Serial solver called for ranges of at most `cutoff` elements.
+ * @param combine Merges the results of the two halves.
+ */
+template <typename T, typename Leaf, typename Combine>
+T divideAndConquer(ForkJoin& fj, std::size_t lo, std::size_t hi, std::size_t cutoff, Leaf& leaf, Combine& combine) {
+    if (hi - lo <= cutoff) {
+        return leaf(lo, hi); // Base case: solve serially.
+    }
+    std::size_t mid = lo + (hi - lo) / 2;
+    T left{}, right{};
+    fj.invoke([&] { left = divideAndConquer<T>(fj, lo, mid, cutoff, leaf, combine); },
+              [&] { right = divideAndConquer<T>(fj, mid, hi, cutoff, leaf, combine); });
+    return combine(left, right);
+}
+
+constexpr std::uint64_t kModulus = 1000000007ull;
+
+// Product of all integers in [lo, hi) modulo kModulus; factorial(n) is rangeProduct(1, n + 1).
+std::uint64_t rangeProduct(ForkJoin& fj, std::uint64_t lo, std::uint64_t hi, std::size_t cutoff = 1 << 16) {
+    auto leaf = [](std::size_t a, std::size_t b) {
+        std::uint64_t p = 1;
+        for (std::size_t i = a; i < b; ++i) {
+            p = p * (i % kModulus) % kModulus;
+        }
+        return p;
+    };
+    auto combine = [](std::uint64_t a, std::uint64_t b) { return a * b % kModulus; };
+    return divideAndConquer<std::uint64_t>(fj, lo, hi, cutoff, leaf, combine);
+}
+
+// Sum of all elements, as a balanced tree reduction.
+long long recursiveSum(ForkJoin& fj, const std::vector<int>& data, std::size_t cutoff = 1 << 16) {
+    auto leaf = [&data](std::size_t a, std::size_t b) {
+        return std::accumulate(data.begin() + a, data.begin() + b, 0LL);
+    };
+    auto combine = [](long long a, long long b) { return a + b; };
+    return divideAndConquer<long long>(fj, 0, data.size(), cutoff, leaf, combine);
+}
+
+// Merges the sorted ranges a[0, na) and b[0, nb) into out, splitting the work recursively:
+// take the median of the larger range, find its position in the other with a binary search,
+// and merge the two lower parts and the two upper parts in parallel.
+void parallelMerge(ForkJoin& fj, const int* a, std::size_t na, const int* b, std::size_t nb, int* out,
+                   std::size_t cutoff) {
+    if (na + nb <= cutoff) {
+        std::merge(a, a + na, b, b + nb, out);
+        return;
+    }
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    std::size_t ma = na / 2;
+    std::size_t mb = static_cast<std::size_t>(std::lower_bound(b, b + nb, a[ma]) - b);
+    fj.invoke([&] { parallelMerge(fj, a, ma, b, mb, out, cutoff); },
+              [&] { parallelMerge(fj, a + ma, na - ma, b + mb, nb - mb, out + ma + mb, cutoff); });
+}
+
+// Sorts data[lo, hi). The result ends up in buffer[lo, hi) if intoBuffer, else in data[lo, hi).
+// Each level sorts its halves into the OTHER array and merges them into its own target, so the
+// two arrays swap roles level by level and no level copies its merge result back.
+void mergeSortRange(ForkJoin& fj, int* data, int* buffer, std::size_t lo, std::size_t hi, std::size_t cutoff,
+                    bool intoBuffer) {
+    if (hi - lo <= cutoff) {
+        std::sort(data + lo, data + hi);
+        if (intoBuffer) {
+            std::copy(data + lo, data + hi, buffer + lo);
+        }
+        return;
+    }
+    std::size_t mid = lo + (hi - lo) / 2;
+    fj.invoke([&] { mergeSortRange(fj, data, buffer, lo, mid, cutoff, !intoBuffer); },
+              [&] { mergeSortRange(fj, data, buffer, mid, hi, cutoff, !intoBuffer); });
+    const int* from = intoBuffer ? data : buffer;
+    int* to = intoBuffer ? buffer : data;
+    parallelMerge(fj, from + lo, mid - lo, from + mid, hi - mid, to + lo, cutoff);
+}
+
+void parallelMergeSort(ForkJoin& fj, std::vector<int>& data, std::size_t cutoff = 1 << 14) {
+    std::vector<int> buffer(data.size());
+    mergeSortRange(fj, data.data(), buffer.data(), 0, data.size(), cutoff, false);
+}
+
+// The serial factorial from 17_recursive_functions.cpp, for comparison.
+int factorial(int n) {
+    if (n == 0) {
+        return 1;
+    }
+    return n * factorial(n - 1);
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main() {
+    ForkJoin fj(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "Factorial of 5 (serial recursion): " << factorial(5) << std::endl;
+    std::cout << "Factorial of 5 (fork-join range product): " << rangeProduct(fj, 1, 6) << std::endl;
+
+    // An exception in either half reaches the caller of invoke() instead of terminating.
+    try {
+        fj.invoke([] { throw std::runtime_error("left half failed"); }, [] {});
+    } catch (const std::exception& e) {
+        std::cout << "Caught from a forked half: " << e.what() << std::endl;
+    }
+
+    // Scaling benchmark inputs.
+    const std::uint64_t productN = 200000000;
+    std::vector<int> numbers(1 << 25);
+    std::mt19937 rng(42);
+    for (int& v : numbers) {
+        v = static_cast<int>(rng() % 1000);
+    }
+    std::vector<int> unsorted(1 << 23);
+    for (int& v : unsorted) {
+        v = static_cast<int>(rng());
+    }
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+
+    std::cout << "threads | range product " << productN << " | sum of " << numbers.size() << " ints | merge sort of "
+              << unsorted.size() << " ints" << std::endl;
+    double base[3] = {0, 0, 0};
+    for (unsigned threads : counts) {
+        ForkJoin pool(threads);
+        std::uint64_t product = 0;
+        long long total = 0;
+        std::vector<int> sorted = unsorted;
+
+        double t0 = timeMs([&] { product = rangeProduct(pool, 1, productN + 1); });
+        double t1 = timeMs([&] { total = recursiveSum(pool, numbers); });
+        double t2 = timeMs([&] { parallelMergeSort(pool, sorted); });
+        if (threads == 1) {
+            base[0] = t0;
+            base[1] = t1;
+            base[2] = t2;
+        }
+
+        std::cout << "  " << threads << "     | " << t0 << " ms (x" << base[0] / t0 << ")"
+                  << " | " << t1 << " ms (x" << base[1] / t1 << ")"
+                  << " | " << t2 << " ms (x" << base[2] / t2 << ")"
+                  << (std::is_sorted(sorted.begin(), sorted.end()) ? "" : " NOT SORTED")
+                  << "  [" << product << ", " << total << "]" << std::endl;
+    }
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Linear vs divide-and-conquer recursion:
+ *    - factorial(n) = n * factorial(n - 1) is a chain: every call waits for the next one.
+ *    - product(lo, hi) = product(lo, mid) * product(mid, hi) splits into two INDEPENDENT calls,
+ *      which is what makes it parallelizable.
+ *
+ * 2. Fork and join:
+ *    - invoke(left, right) offers left to the worker threads, runs right itself and then joins: if
+ *      no worker took left, the caller runs it (plain recursion, no thread involved); otherwise it
+ *      runs other queued halves while it waits, so no thread sits idle in a join.
+ *    - The workers are created once. Starting a std::thread per fork would cost tens of
+ *      microseconds each time and, once the tree is deep, far more threads than cores.
+ *    - Exceptions are caught in whichever thread runs the half and rethrown by invoke() after both
+ *      halves finished, so a throwing half neither terminates the program nor leaves a running
+ *      half behind with dangling references.
+ *
+ * 3. The cutoff:
+ *    - Below the cutoff the leaf function solves the range with a plain loop (or std::sort).
+ *    - Too small a cutoff wastes time on forking; too large a cutoff leaves cores idle.
+ *
+ * Tips and Tricks:
+ * - Merge sort alternates between the array and one buffer (ping-pong): the leaves sort in place and
+ *   copy into the buffer only where their level merges out of it, instead of copying all n elements
+ *   back after every merge level.
+ * - A serial merge step would limit scaling at the top of the sort tree, where one thread merges
+ *   the whole array; parallelMerge() splits each merge by a median so it uses every core too.
+ * - Combine results in a fixed left/right order so the answer does not depend on the thread count.
+ */
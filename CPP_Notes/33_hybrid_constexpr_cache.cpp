@@ -0,0 +1,237 @@
+/**
+ * @file 33_hybrid_constexpr_cache.cpp
+ * @brief Demonstrates one function that folds constant calls at compile time and caches runtime calls.
+ *
+ * 03_compiletime_and _runtime.cpp has two separate functions: `constexpr factorial` for constant
+ * arguments and `factorial_runtime` for everything else, and the caller has to pick the right one by
+ * hand. This file merges both into a single entry point:
+ *
+ * - When the call is evaluated at compile time (e.g. initializing a `constexpr` variable or a
+ *   template argument), the function detects it with `if consteval` (C++23) or
+ *   `std::is_constant_evaluated()` (C++20) and simply computes the value; the result is folded into
+ *   the binary and costs nothing at runtime.
+ * - When the call happens at runtime, it goes through a thread-safe cache of previously computed
+ *   results, so an expensive computation is only done once per argument.
+ *
+ * The cache is sharded: keys are spread over several small hash maps, each with its own
+ * `std::shared_mutex`, so concurrent readers never block each other and writers only lock one shard.
+ *
+ * The microbenchmarks in main() show what each path costs: a folded constant, a direct runtime
+ * computation, a cache hit and a cache miss. They also show that caching only pays off when the
+ * computation is more expensive than a hash lookup; factorial is not, nthPrime is.
+ *
+ * @note Compile with `-std=c++20 -O2 -pthread` (or `-std=c++23` to use `if consteval`).
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// True while the enclosing call is being evaluated by the compiler.
+constexpr bool inConstantEvaluation() {
+#if defined(__cpp_if_consteval)
+    if consteval {
+        return true;
+    } else {
+        return false;
+    }
+#else
+    return std::is_constant_evaluated();
+#endif
+}
+
+/**
+ * @brief Thread-safe memo table split into independently locked shards.
+ */
+template <typename Key, typename Value, std::size_t Shards = 16>
+class ShardedCache {
+public:
+    // Returns the cached value for key, computing and storing it with compute(key) on a miss.
+    template <typename Compute>
+    Value getOrCompute(const Key& key, Compute&& compute) {
+        Shard& shard = shards_[std::hash<Key>{}(key) % Shards];
+        {
+            std::shared_lock<std::shared_mutex> read(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                return it->second;
+            }
+        }
+        // Compute outside the lock so a slow computation does not block readers of this shard.
+        Value value = compute(key);
+        std::unique_lock<std::shared_mutex> write(shard.mutex);
+        return shard.map.try_emplace(key, value).first->second;
+    }
+
+    void clear() {
+        for (Shard& shard : shards_) {
+            std::unique_lock<std::shared_mutex> write(shard.mutex);
+            shard.map.clear();
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<Key, Value> map;
+    };
+    std::array<Shard, Shards> shards_;
+};
+
+// One cache per function, created on first runtime use.
+template <auto Fn, typename Arg>
+auto& cacheFor() {
+    using Result = decltype(Fn(std::declval<Arg>()));
+    static ShardedCache<Arg, Result> cache;
+    return cache;
+}
+
+/**
+ * @brief Evaluates Fn(arg) at compile time when possible, otherwise through the runtime cache.
+ *
+ * Fn must be a constexpr function so the compile-time path is available.
+ */
+template <auto Fn, typename Arg>
+constexpr auto hybrid(Arg arg) {
+    if (inConstantEvaluation()) {
+        return Fn(arg);
+    }
+    return cacheFor<Fn, Arg>().getOrCompute(arg, [](Arg a) { return Fn(a); });
+}
+
+// The constexpr factorial of 03_compiletime_and _runtime.cpp (64-bit so 20! fits).
+constexpr std::uint64_t factorialImpl(int n) {
+    return (n <= 1) ? 1 : (static_cast<std::uint64_t>(n) * factorialImpl(n - 1));
+}
+
+// The n-th prime by trial division: expensive enough that caching it pays off.
+constexpr std::uint64_t nthPrimeImpl(int n) {
+    std::uint64_t candidate = 1;
+    int found = 0;
+    while (found < n) {
+        ++candidate;
+        bool prime = candidate >= 2;
+        for (std::uint64_t d = 2; d * d <= candidate; ++d) {
+            if (candidate % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime) {
+            ++found;
+        }
+    }
+    return candidate;
+}
+
+// The single entry points callers use.
+constexpr std::uint64_t factorial(int n) { return hybrid<factorialImpl>(n); }
+constexpr std::uint64_t nthPrime(int n) { return hybrid<nthPrimeImpl>(n); }
+
+// Keeps the compiler from deleting benchmark loops.
+template <typename T>
+void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Fn>
+double nsPerCall(int calls, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) {
+        fn(i);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / calls;
+}
+
+int main() {
+    // Compile-time path: the same function folds to a constant.
+    constexpr std::uint64_t compileTimeFactorial = factorial(5);
+    static_assert(compileTimeFactorial == 120);
+    static_assert(nthPrime(100) == 541);
+    std::cout << "Compile-time factorial of 5: " << compileTimeFactorial << std::endl;
+
+    // Runtime path: the argument is only known at runtime, so the cache is used.
+    volatile int runtimeArg = 5;
+    std::cout << "Runtime factorial of 5: " << factorial(runtimeArg) << std::endl;
+
+    // Microbenchmarks.
+    const int calls = 2000000;
+    volatile int twenty = 20;
+    volatile int primeIndex = 2000;
+
+    double folded = nsPerCall(calls, [](int) {
+        constexpr std::uint64_t value = factorial(20);
+        doNotOptimize(value);
+    });
+    double directFactorial = nsPerCall(calls, [&](int) { doNotOptimize(factorialImpl(twenty)); });
+    double cachedFactorial = nsPerCall(calls, [&](int) { doNotOptimize(factorial(twenty)); });
+
+    double directPrime = nsPerCall(200, [&](int) { doNotOptimize(nthPrimeImpl(primeIndex)); });
+    double cachedPrime = nsPerCall(calls, [&](int) { doNotOptimize(nthPrime(primeIndex)); });
+
+    cacheFor<nthPrimeImpl, int>().clear();
+    double missPrime = nsPerCall(200, [](int i) { doNotOptimize(nthPrime(1000 + i)); });
+
+    // Concurrent hits from several threads share the read lock.
+    unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < threads; ++t) {
+        readers.emplace_back([&] {
+            for (int i = 0; i < calls / 4; ++i) {
+                doNotOptimize(nthPrime(1000 + (i % 200))); // All cached by the miss run above.
+            }
+        });
+    }
+    for (auto& r : readers) {
+        r.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double concurrent = std::chrono::duration<double, std::nano>(stop - start).count() / (threads * (calls / 4.0));
+
+    std::cout << "Cost per call:" << std::endl;
+    std::cout << "  factorial(20) folded at compile time: " << folded << " ns" << std::endl;
+    std::cout << "  factorial(20) computed at runtime:    " << directFactorial << " ns" << std::endl;
+    std::cout << "  factorial(20) runtime cache hit:      " << cachedFactorial << " ns" << std::endl;
+    std::cout << "  nthPrime(2000) computed at runtime:   " << directPrime << " ns" << std::endl;
+    std::cout << "  nthPrime(2000) runtime cache hit:     " << cachedPrime << " ns" << std::endl;
+    std::cout << "  nthPrime(1000..1199) cache miss:      " << missPrime << " ns" << std::endl;
+    std::cout << "  cache hits from " << threads << " threads:          " << concurrent
+              << " ns (wall time per call)" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Detecting compile-time evaluation:
+ *    - std::is_constant_evaluated() (and `if consteval` in C++23) return true only while the
+ *      compiler itself is evaluating the call, e.g. for a constexpr variable or a static_assert.
+ *    - In that branch we may only do constexpr things, so we just compute the value.
+ *
+ * 2. The runtime branch:
+ *    - It may call ordinary functions, so it can use a static cache protected by locks.
+ *    - The first call for an argument computes and stores the result; later calls are a hash lookup
+ *      under a shared (reader) lock.
+ *
+ * 3. When caching is worth it:
+ *    - factorial(20) is about twenty multiplications, cheaper than any hash lookup; caching it makes
+ *      it slower. nthPrime(2000) takes microseconds, so a cache hit is orders of magnitude faster.
+ *
+ * Tips and Tricks:
+ * - A runtime call with a constant argument (factorial(5) in a normal expression) is NOT guaranteed
+ *   to be evaluated at compile time; assign it to a constexpr variable to force folding.
+ * - Only memoize pure functions: the cached result must depend on the argument alone.
+ * - Unbounded caches grow forever; bound them (LRU, fixed size) if the argument space is large.
+ */
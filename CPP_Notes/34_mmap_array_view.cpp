@@ -0,0 +1,328 @@
+/**
+ * @file 34_mmap_array_view.cpp
+ * @brief Demonstrates zero-copy loading of binary integer arrays with a memory-mapped, read-only view.
+ *
+ * `printVector` and `printArray` in 13_raw_arrays.cpp work on containers filled from initializer lists.
+ * Real datasets are large binary files. Reading such a file into a `std::vector` copies every byte
+ * from the OS page cache into the vector, so the data exists twice in RAM and nothing can be used
+ * until the whole file has been read.
+ *
+ * Memory mapping asks the OS to make the file itself appear in the address space:
+ * - No copy: the pages of the page cache are mapped directly, so peak memory is one copy of the data.
+ * - Lazy: pages are loaded on first touch, so "opening" a multi-GB file is instant.
+ * - Typed access: `MappedArray<int>` exposes the bytes as a `std::span<const int>`, which works with
+ *   range-based for loops, indexing and the print helpers below.
+ * - Hints: `madvise(MADV_SEQUENTIAL)` tells the kernel to read ahead aggressively and drop pages behind
+ *   us; `MADV_WILLNEED` starts reading the file in the background right away; `MAP_POPULATE` (optional)
+ *   pre-faults every page during mmap() so the first loop never stalls on a page fault.
+ *
+ * The benchmark in main() writes a 256 MB test file and compares load time, first-pass time and
+ * resident memory (RSS) of `std::ifstream` + `std::vector` against the mapped view, with the file
+ * evicted from the page cache (cold) and already cached (warm).
+ *
+ * @note POSIX (Linux/macOS) implementation with a Windows fallback using file mapping objects.
+ *       Compile with `-std=c++20 -O2`.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only memory-mapped view of a binary file of trivially copyable T values.
+ *
+ * The file must contain a whole number of T values in native byte order. The mapping is released
+ * when the object is destroyed; spans obtained from it must not outlive it.
+ */
+template <typename T>
+class MappedArray {
+public:
+    enum class Access { Default, Sequential };
+
+    struct Options {
+        Access access = Access::Sequential; // madvise(MADV_SEQUENTIAL)
+        bool willNeed = true;                // madvise(MADV_WILLNEED): start read-ahead now
+        bool populate = false;               // MAP_POPULATE: pre-fault all pages in mmap()
+    };
+
+    explicit MappedArray(const std::string& path) : MappedArray(path, Options{}) {}
+
+    MappedArray(const std::string& path, Options options) {
+#if defined(_WIN32)
+        (void)options;
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        LARGE_INTEGER size;
+        GetFileSizeEx(file_, &size);
+        bytes_ = static_cast<std::size_t>(size.QuadPart);
+        if (bytes_ > 0) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            data_ = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!data_) {
+                release();
+                throw std::runtime_error("cannot map " + path);
+            }
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            release();
+            throw std::runtime_error("cannot stat " + path);
+        }
+        bytes_ = static_cast<std::size_t>(st.st_size);
+        if (bytes_ > 0) {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (options.populate) {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            void* p = ::mmap(nullptr, bytes_, PROT_READ, flags, fd_, 0);
+            if (p == MAP_FAILED) {
+                release();
+                throw std::runtime_error("cannot mmap " + path);
+            }
+            data_ = p;
+            if (options.access == Access::Sequential) {
+                ::madvise(data_, bytes_, MADV_SEQUENTIAL);
+            }
+            if (options.willNeed) {
+                ::madvise(data_, bytes_, MADV_WILLNEED);
+            }
+        }
+#endif
+        if (bytes_ % sizeof(T) != 0) {
+            release();
+            throw std::runtime_error(path + " is not a whole number of elements");
+        }
+    }
+
+    MappedArray(MappedArray&& other) noexcept { swap(other); }
+    MappedArray& operator=(MappedArray&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator=(const MappedArray&) = delete;
+    ~MappedArray() { release(); }
+
+    std::span<const T> span() const { return {static_cast<const T*>(data_), bytes_ / sizeof(T)}; }
+    const T* data() const { return static_cast<const T*>(data_); }
+    std::size_t size() const { return bytes_ / sizeof(T); }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+private:
+    void swap(MappedArray& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(bytes_, other.bytes_);
+#if defined(_WIN32)
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#else
+        std::swap(fd_, other.fd_);
+#endif
+    }
+
+    void release() {
+#if defined(_WIN32)
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        mapping_ = nullptr;
+#else
+        if (data_) ::munmap(data_, bytes_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        bytes_ = 0;
+    }
+
+    void* data_ = nullptr;
+    std::size_t bytes_ = 0;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// printArray from 13_raw_arrays.cpp, taking a const pointer so read-only views can be printed.
+void printArray(const int arr[], std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        std::cout << arr[i] << " ";
+    }
+    std::cout << std::endl;
+}
+
+// printVector from 13_raw_arrays.cpp, generalized to any contiguous int sequence.
+void printVector(std::span<const int> vec) {
+    for (const auto& elem : vec) {
+        std::cout << elem << " ";
+    }
+    std::cout << std::endl;
+}
+
+// The classic approach: read the whole file into a vector.
+std::vector<int> readWithStream(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::size_t bytes = static_cast<std::size_t>(in.tellg());
+    std::vector<int> values(bytes / sizeof(int));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(int)));
+    return values;
+}
+
+long long sumAll(std::span<const int> values) {
+    return std::accumulate(values.begin(), values.end(), 0LL);
+}
+
+#if !defined(_WIN32)
+struct Resident {
+    double totalMb = 0;   // Everything resident, including mapped file pages.
+    double privateMb = 0; // Anonymous memory (heap, stack) only: copies we made ourselves.
+};
+
+// Resident set size of this process (Linux /proc; zeros elsewhere).
+Resident residentMb() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0, shared = 0;
+    statm >> pages >> resident >> shared;
+    double pageMb = static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+    return {static_cast<double>(resident) * pageMb, static_cast<double>(resident - shared) * pageMb};
+}
+
+// Drops the file's pages from the OS page cache so the next read comes from disk.
+void evictFromPageCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+        ::close(fd);
+    }
+}
+#else
+struct Resident {
+    double totalMb = 0;
+    double privateMb = 0;
+};
+Resident residentMb() { return {}; }
+void evictFromPageCache(const std::string&) {}
+#endif
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Loads the file with `load`, sums it once and reports the timings and the RSS growth.
+template <typename Load>
+void measure(const char* label, const std::string& path, bool cold, Load load) {
+    if (cold) {
+        evictFromPageCache(path);
+    }
+    Resident before = residentMb();
+    auto start = std::chrono::steady_clock::now();
+    auto data = load();
+    double loadMs = msSince(start);
+    auto passStart = std::chrono::steady_clock::now();
+    long long sum = sumAll(std::span<const int>(data.data(), data.size()));
+    double passMs = msSince(passStart);
+    Resident after = residentMb();
+    std::cout << "  " << label << (cold ? " (cold)" : " (warm)") << ": load " << loadMs << " ms, first pass "
+              << passMs << " ms, RSS +" << after.totalMb - before.totalMb << " MB of which private +"
+              << after.privateMb - before.privateMb << " MB (sum " << sum << ")" << std::endl;
+}
+
+int main() {
+    const std::string path = "mmap_array_view_bench.bin";
+
+    // Write a 256 MB file of consecutive ints.
+    const std::size_t count = std::size_t{64} << 20;
+    {
+        std::vector<int> values(count);
+        std::iota(values.begin(), values.end(), 0);
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(count * sizeof(int)));
+    }
+
+    {
+        MappedArray<int> view(path);
+        std::cout << "First elements of the mapped file: ";
+        printArray(view.data(), 5);
+        std::cout << "Last elements of the mapped file: ";
+        printVector(view.span().last(5));
+    }
+
+    std::cout << "Loading " << count << " ints (" << count * sizeof(int) / (1024 * 1024) << " MB):" << std::endl;
+    for (bool cold : {true, false}) {
+        measure("ifstream + vector  ", path, cold, [&] { return readWithStream(path); });
+        measure("mmap               ", path, cold, [&] { return MappedArray<int>(path); });
+        measure("mmap + MAP_POPULATE", path, cold, [&] {
+            MappedArray<int>::Options options;
+            options.populate = true;
+            return MappedArray<int>(path, options);
+        });
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Where the copy goes:
+ *    - ifstream::read copies from the page cache into the vector, so while the vector is alive the
+ *      data is in RAM twice (the cache pages can be evicted later, but the peak is doubled).
+ *    - mmap maps the page cache pages themselves. RSS still grows by the pages we touch, but they are
+ *      shared file pages the kernel can drop at any time, not private memory: the "private" column
+ *      stays near zero.
+ *
+ * 2. Load time vs first-pass time:
+ *    - The vector is fully loaded before the first element can be used.
+ *    - The plain mapping returns immediately and pays for I/O during the first pass (page faults).
+ *    - MAP_POPULATE moves that cost back into the load step, which helps when the first pass is
+ *      latency sensitive.
+ *
+ * 3. Cold vs warm:
+ *    - Cold runs read from disk and are dominated by I/O; MADV_SEQUENTIAL/WILLNEED increase read-ahead.
+ *    - Warm runs show the pure copy cost that mmap avoids.
+ *
+ * Tips and Tricks:
+ * - The file must not be truncated while mapped; accessing pages past the new end raises SIGBUS.
+ * - Binary files are in the byte order of the machine that wrote them; agree on one format.
+ * - For random access over a huge file, drop MADV_SEQUENTIAL (it makes the kernel discard pages).
+ */
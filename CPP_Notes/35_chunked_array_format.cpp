@@ -0,0 +1,447 @@
+/**
+ * @file 35_chunked_array_format.cpp
+ * @brief Demonstrates a chunked on-disk array format with a double-buffered streaming reader.
+ *
+ * Everything in 13_raw_arrays.cpp and 14_loops.cpp assumes the whole array fits in memory. For data
+ * larger than RAM we need to stream it: keep only a small window in memory and process the file
+ * piece by piece, ideally at the speed of the disk.
+ *
+ * The format in this file is deliberately simple:
+ *
+ *     FileHeader   magic, version, element size, elements per chunk, chunk count, total count
+ *     Chunk 0      ChunkHeader {count, min, max, checksum}  +  chunkElements ints
+ *     Chunk 1      ...
+ *
+ * Every chunk occupies the same number of bytes on disk (the last one is padded), so the offset of
+ * chunk i is a multiplication, and every chunk carries its own statistics and checksum.
+ *
+ * - `ChunkedArrayWriter` appends values and emits a chunk whenever one fills up.
+ * - `ChunkedArrayReader::forEachChunk` streams the chunks to a callback. A background thread reads
+ *   chunk i + 1 while the callback processes chunk i (double buffering), so I/O and computation
+ *   overlap. Checksums are verified before a chunk is handed out, and a truncated file or a chunk
+ *   header whose count exceeds the chunk capacity is reported as an error instead of being read.
+ * - Range queries pass `[lo, hi]`: a chunk whose `[min, max]` does not overlap the range is skipped
+ *   after reading only its 24-byte header, never its data.
+ *
+ * The benchmark in main() compares a full streaming scan with loading everything into a vector, and
+ * a range query with and without chunk skipping.
+ *
+ * @note Values are stored in the byte order of the writing machine. Compile with `-std=c++20 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct FileHeader {
+    char magic[8];                // "CHUNKARR"
+    std::uint32_t version;        // 1
+    std::uint32_t elementSize;    // sizeof(int)
+    std::uint64_t chunkElements;  // capacity of every chunk
+    std::uint64_t chunkCount;
+    std::uint64_t totalCount;
+};
+
+struct ChunkHeader {
+    std::uint32_t count;    // valid elements in this chunk
+    std::int32_t min;
+    std::int32_t max;
+    std::uint32_t checksum; // FNV-1a over the valid elements
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 40 && sizeof(ChunkHeader) == 24, "unexpected on-disk layout");
+
+constexpr char kMagic[8] = {'C', 'H', 'U', 'N', 'K', 'A', 'R', 'R'};
+
+// FNV-1a over 32-bit words: cheap, and catches torn or corrupted chunks.
+std::uint32_t checksum(std::span<const int> values) {
+    std::uint32_t h = 2166136261u;
+    for (int v : values) {
+        h = (h ^ static_cast<std::uint32_t>(v)) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Writes values into the chunked format. Call close() (or let the destructor do it).
+ */
+class ChunkedArrayWriter {
+public:
+    ChunkedArrayWriter(const std::string& path, std::size_t chunkElements)
+        : out_(path, std::ios::binary | std::ios::trunc), chunkElements_(chunkElements) {
+        if (!out_) {
+            throw std::runtime_error("cannot create " + path);
+        }
+        buffer_.reserve(chunkElements_);
+        FileHeader header{};
+        out_.write(reinterpret_cast<const char*>(&header), sizeof header); // patched in close()
+    }
+
+    ~ChunkedArrayWriter() {
+        if (!closed_) {
+            close();
+        }
+    }
+
+    void append(int value) {
+        buffer_.push_back(value);
+        if (buffer_.size() == chunkElements_) {
+            flushChunk();
+        }
+    }
+
+    void append(std::span<const int> values) {
+        for (int v : values) {
+            append(v);
+        }
+    }
+
+    void close() {
+        if (!buffer_.empty()) {
+            flushChunk();
+        }
+        FileHeader header{};
+        std::copy(std::begin(kMagic), std::end(kMagic), header.magic);
+        header.version = 1;
+        header.elementSize = sizeof(int);
+        header.chunkElements = chunkElements_;
+        header.chunkCount = chunkCount_;
+        header.totalCount = totalCount_;
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof header);
+        out_.close();
+        closed_ = true;
+    }
+
+private:
+    void flushChunk() {
+        ChunkHeader ch{};
+        ch.count = static_cast<std::uint32_t>(buffer_.size());
+        auto [lo, hi] = std::minmax_element(buffer_.begin(), buffer_.end());
+        ch.min = *lo;
+        ch.max = *hi;
+        ch.checksum = checksum(buffer_);
+        out_.write(reinterpret_cast<const char*>(&ch), sizeof ch);
+        buffer_.resize(chunkElements_, 0); // Pad the last chunk so every chunk has the same size.
+        out_.write(reinterpret_cast<const char*>(buffer_.data()),
+                   static_cast<std::streamsize>(chunkElements_ * sizeof(int)));
+        totalCount_ += ch.count;
+        ++chunkCount_;
+        buffer_.clear();
+    }
+
+    std::ofstream out_;
+    std::size_t chunkElements_;
+    std::vector<int> buffer_;
+    std::uint64_t chunkCount_ = 0;
+    std::uint64_t totalCount_ = 0;
+    bool closed_ = false;
+};
+
+/**
+ * @brief Streams a chunked array file with background read-ahead.
+ */
+class ChunkedArrayReader {
+public:
+    struct Stats {
+        std::uint64_t chunksRead = 0;
+        std::uint64_t chunksSkipped = 0;
+        std::uint64_t bytesRead = 0;
+    };
+
+    explicit ChunkedArrayReader(std::string path) : path_(std::move(path)) {
+        std::ifstream in(path_, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&header_), sizeof header_);
+        if (!in || !std::equal(std::begin(kMagic), std::end(kMagic), header_.magic) || header_.version != 1 ||
+            header_.elementSize != sizeof(int) || header_.chunkElements == 0 ||
+            header_.chunkElements > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error(path_ + " is not a chunked int array");
+        }
+    }
+
+    std::uint64_t size() const { return header_.totalCount; }
+    std::uint64_t chunkCount() const { return header_.chunkCount; }
+
+    /**
+     * @brief Calls fn(values, header) for every chunk whose [min, max] overlaps [lo, hi].
+     *
+     * Chunk i + 1 is read on a background thread while fn processes chunk i.
+     */
+    Stats forEachChunk(const std::function<void(std::span<const int>, const ChunkHeader&)>& fn,
+                       int lo = std::numeric_limits<int>::min(), int hi = std::numeric_limits<int>::max()) const {
+        struct Slot {
+            std::vector<int> data;
+            ChunkHeader header{};
+            bool full = false;
+            bool last = false;
+            std::string problem; // Set on the last slot when the file is truncated or corrupt.
+        };
+        Slot slots[2];
+        for (Slot& s : slots) {
+            s.data.resize(header_.chunkElements);
+        }
+        std::mutex m;
+        std::condition_variable cv;
+        Stats stats;
+        bool corrupt = false;
+
+        // Producer: fills the two slots alternately, skipping chunks outside [lo, hi].
+        std::thread reader([&] {
+            std::ifstream in(path_, std::ios::binary);
+            const std::uint64_t stride = sizeof(ChunkHeader) + header_.chunkElements * sizeof(int);
+            int next = 0;
+            for (std::uint64_t c = 0; c <= header_.chunkCount; ++c) {
+                Slot& slot = slots[next];
+                {
+                    std::unique_lock<std::mutex> lock(m);
+                    cv.wait(lock, [&] { return !slot.full; });
+                    if (c == header_.chunkCount || corrupt) {
+                        slot.last = true;
+                        slot.full = true;
+                        cv.notify_all();
+                        break;
+                    }
+                }
+                // Never trust the file: a short read would leave the previous chunk in the slot, and
+                // a count above the capacity would overflow the buffer.
+                std::string problem;
+                in.seekg(static_cast<std::streamoff>(sizeof(FileHeader) + c * stride));
+                in.read(reinterpret_cast<char*>(&slot.header), sizeof(ChunkHeader));
+                if (!in || in.gcount() != static_cast<std::streamsize>(sizeof(ChunkHeader))) {
+                    problem = "truncated chunk header";
+                } else if (slot.header.count > header_.chunkElements) {
+                    problem = "chunk count exceeds the chunk capacity";
+                } else if (slot.header.max < lo || slot.header.min > hi) {
+                    ++stats.chunksSkipped; // Only the producer touches the counters.
+                    continue;
+                } else {
+                    const auto bytes = static_cast<std::streamsize>(slot.header.count * sizeof(int));
+                    in.read(reinterpret_cast<char*>(slot.data.data()), bytes);
+                    if (!in || in.gcount() != bytes) {
+                        problem = "truncated chunk data";
+                    }
+                }
+                if (!problem.empty()) {
+                    std::lock_guard<std::mutex> lock(m);
+                    slot.problem = path_ + ": " + problem + " in chunk " + std::to_string(c);
+                    slot.last = true;
+                    slot.full = true;
+                    cv.notify_all();
+                    break;
+                }
+                stats.bytesRead += sizeof(ChunkHeader) + slot.header.count * sizeof(int);
+                ++stats.chunksRead;
+                std::lock_guard<std::mutex> lock(m);
+                slot.full = true;
+                cv.notify_all();
+                next ^= 1;
+            }
+        });
+
+        // Consumer: processes the slots in the same alternating order.
+        int current = 0;
+        std::exception_ptr error;
+        while (true) {
+            Slot& slot = slots[current];
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] { return slot.full; });
+            }
+            if (slot.last) {
+                if (!slot.problem.empty() && !error) {
+                    error = std::make_exception_ptr(std::runtime_error(slot.problem));
+                }
+                break;
+            }
+            std::span<const int> values(slot.data.data(), slot.header.count);
+            if (!error) {
+                try {
+                    if (checksum(values) != slot.header.checksum) {
+                        throw std::runtime_error("checksum mismatch in " + path_);
+                    }
+                    fn(values, slot.header);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            std::lock_guard<std::mutex> lock(m);
+            corrupt = corrupt || static_cast<bool>(error);
+            slot.full = false;
+            cv.notify_all();
+            current ^= 1;
+        }
+        reader.join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return stats;
+    }
+
+private:
+    std::string path_;
+    FileHeader header_{};
+};
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    const std::string path = "chunked_array_bench.bin";
+    const std::size_t count = std::size_t{64} << 20; // 256 MB of ints
+    const std::size_t chunkElements = std::size_t{1} << 18; // 1 MB chunks
+
+    // A slowly increasing series with noise (timestamps, sorted ids, sensor data...).
+    {
+        std::mt19937 rng(7);
+        ChunkedArrayWriter writer(path, chunkElements);
+        for (std::size_t i = 0; i < count; ++i) {
+            writer.append(static_cast<int>(i / 4 + rng() % 1024));
+        }
+    }
+    ChunkedArrayReader reader(path);
+    std::cout << "File holds " << reader.size() << " ints in " << reader.chunkCount() << " chunks" << std::endl;
+
+    // The loop from 14_loops.cpp, but over a stream: only two chunks are ever in memory.
+    std::cout << "First chunk starts with: ";
+    bool printed = false;
+    reader.forEachChunk([&](std::span<const int> values, const ChunkHeader&) {
+        if (!printed) {
+            for (const int& value : values.first(5)) {
+                std::cout << value << " ";
+            }
+            std::cout << std::endl;
+            printed = true;
+        }
+    });
+
+    const double mb = static_cast<double>(count * sizeof(int)) / (1024.0 * 1024.0);
+
+    // Full scan: streaming vs loading everything into a vector first.
+    long long streamSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    reader.forEachChunk([&](std::span<const int> values, const ChunkHeader&) {
+        for (int v : values) {
+            streamSum += v;
+        }
+    });
+    double streamMs = msSince(start);
+
+    long long vectorSum = 0;
+    start = std::chrono::steady_clock::now();
+    {
+        std::vector<int> all;
+        all.reserve(count);
+        reader.forEachChunk([&](std::span<const int> values, const ChunkHeader&) {
+            all.insert(all.end(), values.begin(), values.end());
+        });
+        for (int v : all) {
+            vectorSum += v;
+        }
+    }
+    double vectorMs = msSince(start);
+
+    // Range query: sum of values in [lo, hi], with and without chunk skipping.
+    const int lo = 5000000, hi = 5500000;
+    auto rangeSum = [&](std::span<const int> values, long long& acc) {
+        for (int v : values) {
+            if (v >= lo && v <= hi) {
+                acc += v;
+            }
+        }
+    };
+    long long fullRange = 0, skippedRange = 0;
+    start = std::chrono::steady_clock::now();
+    auto fullStats = reader.forEachChunk([&](std::span<const int> v, const ChunkHeader&) { rangeSum(v, fullRange); });
+    double fullRangeMs = msSince(start);
+    start = std::chrono::steady_clock::now();
+    auto skipStats = reader.forEachChunk([&](std::span<const int> v, const ChunkHeader&) { rangeSum(v, skippedRange); },
+                                         lo, hi);
+    double skipRangeMs = msSince(start);
+
+    std::cout << "Full scan of " << mb << " MB:" << std::endl;
+    std::cout << "  streaming, 2 chunks in memory: " << streamMs << " ms (" << mb / (streamMs / 1000.0)
+              << " MB/s, sum " << streamSum << ")" << std::endl;
+    std::cout << "  load all into a vector:        " << vectorMs << " ms (" << mb / (vectorMs / 1000.0)
+              << " MB/s, sum " << vectorSum << ")" << std::endl;
+    std::cout << "Range query [" << lo << ", " << hi << "]:" << std::endl;
+    std::cout << "  read every chunk:  " << fullRangeMs << " ms, " << fullStats.chunksRead << " chunks read (sum "
+              << fullRange << ")" << std::endl;
+    std::cout << "  skip by min/max:   " << skipRangeMs << " ms, " << skipStats.chunksRead << " chunks read, "
+              << skipStats.chunksSkipped << " skipped (sum " << skippedRange << ")" << std::endl;
+
+    // Damaged files are rejected instead of replaying stale data or overflowing the buffer.
+    const std::string damaged = "chunked_array_damaged.bin";
+    const std::uint64_t stride = sizeof(ChunkHeader) + chunkElements * sizeof(int);
+    auto tryRead = [&](const char* label) {
+        try {
+            ChunkedArrayReader(damaged).forEachChunk([](std::span<const int>, const ChunkHeader&) {});
+            std::cout << "  " << label << ": not detected" << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << "  " << label << ": " << e.what() << std::endl;
+        }
+    };
+    std::cout << "Damaged files:" << std::endl;
+    std::filesystem::copy_file(path, damaged, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(damaged, sizeof(FileHeader) + 3 * stride + stride / 2);
+    tryRead("truncated in chunk 3");
+    {
+        std::fstream file(damaged, std::ios::binary | std::ios::in | std::ios::out);
+        ChunkHeader hostile{};
+        hostile.count = 0xFFFFFFFFu;
+        hostile.max = std::numeric_limits<int>::max();
+        file.seekp(static_cast<std::streamoff>(sizeof(FileHeader) + stride));
+        file.write(reinterpret_cast<const char*>(&hostile), sizeof hostile);
+    }
+    tryRead("oversized count in chunk 1");
+    std::remove(damaged.c_str());
+
+    std::remove(path.c_str());
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Fixed-size chunks:
+ *    - Because every chunk has the same size on disk, the reader can seek straight to chunk i and
+ *      only ever needs two chunk-sized buffers, regardless of the file size.
+ *
+ * 2. Double buffering:
+ *    - While the callback works on one buffer, the background thread fills the other. When the
+ *      callback is faster than the disk the loop runs at disk speed; when it is slower, reading is
+ *      completely hidden.
+ *
+ * 3. Per-chunk statistics:
+ *    - min/max let a range query discard a chunk after reading 24 bytes instead of 1 MB.
+ *    - They work best on data that is roughly sorted or clustered (time series, ids).
+ *    - count marks how much of the (padded) last chunk is real data; checksum detects corruption.
+ *
+ * 4. Validating the file:
+ *    - Headers come from disk, so they are checked before they are used: count must fit in the
+ *      buffer, and every read must return all requested bytes. Otherwise a truncated file would hand
+ *      out the previous chunk again, still in the slot and with a matching checksum.
+ *
+ * Tips and Tricks:
+ * - Choose chunks of about 1-8 MB: large enough for efficient sequential I/O, small enough that
+ *   skipping is selective.
+ * - To process files larger than RAM, never collect chunks into a container as the "load all into a
+ *   vector" variant does; that variant exists only as a comparison.
+ */
@@ -0,0 +1,434 @@
+/**
+ * @file 36_checked_span.cpp
+ * @brief Demonstrates a bounds-checked span that costs nothing in release builds.
+ *
+ * 26_pointer_array_arithmetic.cpp walks an array with `*(ptr + i)` and `p < arr + 5`, with the size
+ * hardcoded, and `printArray(int arr[], int size)` in 13_raw_arrays.cpp simply trusts the size it is
+ * given. A wrong size or a pointer into a vector that has since reallocated silently reads garbage.
+ *
+ * `checked_span<T>` bundles the pointer with its size and behaves in one of two ways:
+ *
+ * - **Debug configuration** (NDEBUG not defined): every `operator[]`, iterator dereference and
+ *   iterator step is bounds checked, and spans taken from a `CheckedBuffer` remember the buffer's
+ *   *generation*. Any operation that may reallocate the buffer bumps the generation, so using a span
+ *   or iterator obtained before the reallocation is reported as iterator invalidation.
+ * - **Release configuration** (NDEBUG defined): the class holds exactly a pointer and a size,
+ *   `operator[]` is `data_[i]` and the iterators ARE raw pointers. The optimizer sees the same code as
+ *   the raw-pointer loop, so the generated instructions are identical.
+ *
+ * Violations call a handler; the default prints the problem and calls `std::abort()`. The demo in
+ * main() installs a throwing handler so it can show each check and keep running.
+ *
+ * That the release build has no overhead is checked by 36_checked_span_asm_check.sh: it compiles
+ * this file with `-O2 -DNDEBUG -S` and diffs the instructions of `sumRaw` and `sumChecked` (labels
+ * renumbered, equality-compare operand order ignored) and fails if they differ:
+ *
+ *     sh 36_checked_span_asm_check.sh [compiler]
+ *
+ * The benchmark in main() times both, plus `sumIndexed` (an `operator[]` loop).
+ *
+ * @note Compile with `-std=c++17 -O2` (debug checks) or `-std=c++17 -O2 -DNDEBUG` (release).
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if !defined(NDEBUG)
+#define CHECKED_SPAN_CHECKS 1
+#else
+#define CHECKED_SPAN_CHECKS 0
+#endif
+
+// Called when a check fails. Replace it to log, throw or break into a debugger.
+using CheckFailedHandler = void (*)(const char* what);
+
+inline void defaultCheckFailed(const char* what) {
+    std::fprintf(stderr, "checked_span: %s\n", what);
+    std::abort();
+}
+
+inline CheckFailedHandler& checkFailedHandler() {
+    static CheckFailedHandler handler = defaultCheckFailed;
+    return handler;
+}
+
+// A handler may throw; if it returns, the program aborts so the failed access never runs.
+[[noreturn]] inline void checkFailed(const char* what) {
+    checkFailedHandler()(what);
+    std::abort();
+}
+
+#if CHECKED_SPAN_CHECKS
+#define CHECKED_SPAN_REQUIRE(cond, what) \
+    do {                                 \
+        if (!(cond)) {                   \
+            checkFailed(what);           \
+        }                                \
+    } while (0)
+#endif
+
+template <typename T>
+class checked_span;
+
+template <typename T>
+struct is_checked_span : std::false_type {};
+template <typename T>
+struct is_checked_span<checked_span<T>> : std::true_type {};
+template <typename T>
+constexpr bool is_checked_span_v = is_checked_span<T>::value;
+
+/**
+ * @brief Non-owning view of `size` contiguous T values, checked in debug builds only.
+ */
+template <typename T>
+class checked_span {
+public:
+#if CHECKED_SPAN_CHECKS
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_cv_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        iterator(const checked_span* span, T* ptr) : span_(*span), ptr_(ptr) {}
+
+        T& operator*() const {
+            span_.checkValid();
+            CHECKED_SPAN_REQUIRE(ptr_ >= span_.data_ && ptr_ < span_.data_ + span_.size_,
+                                 "dereferencing an iterator outside the span");
+            return *ptr_;
+        }
+        T* operator->() const { return &**this; }
+        T& operator[](difference_type n) const { return *(*this + n); }
+
+        iterator& operator++() { return *this += 1; }
+        iterator operator++(int) { iterator old = *this; ++*this; return old; }
+        iterator& operator--() { return *this -= 1; }
+        iterator operator--(int) { iterator old = *this; --*this; return old; }
+
+        iterator& operator+=(difference_type n) {
+            // Check the offset before forming the pointer: pointers outside the array are UB.
+            difference_type offset = (ptr_ - span_.data_) + n;
+            CHECKED_SPAN_REQUIRE(offset >= 0 && offset <= static_cast<difference_type>(span_.size_),
+                                 "iterator moved outside the span");
+            ptr_ = span_.data_ + offset;
+            return *this;
+        }
+        iterator& operator-=(difference_type n) { return *this += -n; }
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const iterator& a, const iterator& b) { return a.ptr_ - b.ptr_; }
+
+        friend bool operator==(const iterator& a, const iterator& b) {
+            CHECKED_SPAN_REQUIRE(a.span_.data() == b.span_.data(), "comparing iterators of different spans");
+            return a.ptr_ == b.ptr_;
+        }
+        friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+        friend bool operator<(const iterator& a, const iterator& b) { return a.ptr_ < b.ptr_; }
+
+    private:
+        checked_span span_; // Copy of the span: carries bounds and generation.
+        T* ptr_ = nullptr;
+    };
+#else
+    using iterator = T*; // Release: iterators are plain pointers.
+#endif
+
+    checked_span() = default;
+    checked_span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+    template <std::size_t N>
+    checked_span(T (&array)[N]) : data_(array), size_(N) {}
+
+    // Any contiguous container except another checked_span: copies and const conversions must go
+    // through the constructors below, which keep the generation.
+    template <typename Container, typename = std::enable_if_t<!is_checked_span_v<std::remove_cv_t<Container>>>,
+              typename = decltype(std::declval<Container&>().data())>
+    checked_span(Container& c) : data_(c.data()), size_(c.size()) {}
+
+    // Allow checked_span<int> -> checked_span<const int>.
+    template <typename U>
+    checked_span(const checked_span<U>& other)
+        : data_(other.data_), size_(other.size_)
+#if CHECKED_SPAN_CHECKS
+        , generation_(other.generation_), seenGeneration_(other.seenGeneration_)
+#endif
+    {
+    }
+
+    T& operator[](std::size_t i) const {
+#if CHECKED_SPAN_CHECKS
+        checkValid();
+        CHECKED_SPAN_REQUIRE(i < size_, "index out of range");
+#endif
+        return data_[i];
+    }
+
+    T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+#if CHECKED_SPAN_CHECKS
+    iterator begin() const { checkValid(); return iterator(this, data_); }
+    iterator end() const { checkValid(); return iterator(this, data_ + size_); }
+#else
+    iterator begin() const { return data_; }
+    iterator end() const { return data_ + size_; }
+#endif
+
+    checked_span subspan(std::size_t offset, std::size_t count) const {
+#if CHECKED_SPAN_CHECKS
+        CHECKED_SPAN_REQUIRE(offset <= size_ && count <= size_ - offset, "subspan out of range");
+#endif
+        checked_span s = *this;
+        s.data_ += offset;
+        s.size_ = count;
+        return s;
+    }
+
+private:
+    template <typename U>
+    friend class checked_span;
+    template <typename U>
+    friend class CheckedBuffer;
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+
+#if CHECKED_SPAN_CHECKS
+    void checkValid() const {
+        CHECKED_SPAN_REQUIRE(generation_ == nullptr || *generation_ == seenGeneration_,
+                             "span used after its buffer was reallocated, reassigned or destroyed");
+    }
+
+    // Owner's generation counter, if any. Shared, so the counter outlives a destroyed or moved-from
+    // buffer and the check still has something valid to read.
+    std::shared_ptr<const std::uint64_t> generation_;
+    std::uint64_t seenGeneration_ = 0;
+#endif
+};
+
+/**
+ * @brief std::vector wrapper that invalidates outstanding checked spans when it reallocates.
+ *
+ * Copies and moves are allowed. Each buffer object has its own generation counter; assigning to
+ * a buffer, moving from it and destroying it all invalidate the spans taken from it.
+ */
+template <typename T>
+class CheckedBuffer {
+public:
+    CheckedBuffer() = default;
+    CheckedBuffer(std::initializer_list<T> init) : data_(init) {}
+    explicit CheckedBuffer(std::size_t n, const T& value = T()) : data_(n, value) {}
+
+    CheckedBuffer(const CheckedBuffer& other) : data_(other.data_) {}
+    CheckedBuffer(CheckedBuffer&& other) : data_(std::move(other.data_)) { other.invalidate(); }
+    CheckedBuffer& operator=(const CheckedBuffer& other) {
+        if (this != &other) {
+            invalidate();
+            data_ = other.data_;
+        }
+        return *this;
+    }
+    CheckedBuffer& operator=(CheckedBuffer&& other) {
+        if (this != &other) {
+            invalidate();
+            other.invalidate();
+            data_ = std::move(other.data_);
+        }
+        return *this;
+    }
+    ~CheckedBuffer() { invalidate(); }
+
+    void push_back(const T& value) {
+        if (data_.size() == data_.capacity()) {
+            invalidate(); // About to reallocate.
+        }
+        data_.push_back(value);
+    }
+    void resize(std::size_t n) { invalidate(); data_.resize(n); }
+    void clear() { invalidate(); data_.clear(); }
+
+    checked_span<T> span() { return makeSpan<T>(data_.data()); }
+    checked_span<const T> span() const { return makeSpan<const T>(data_.data()); }
+    std::size_t size() const { return data_.size(); }
+
+private:
+    template <typename U>
+    checked_span<U> makeSpan(U* data) const {
+        checked_span<U> s(data, data_.size());
+#if CHECKED_SPAN_CHECKS
+        s.generation_ = generation_;
+        s.seenGeneration_ = *generation_;
+#endif
+        return s;
+    }
+
+    void invalidate() {
+#if CHECKED_SPAN_CHECKS
+        ++*generation_;
+#endif
+    }
+
+    std::vector<T> data_;
+#if CHECKED_SPAN_CHECKS
+    std::shared_ptr<std::uint64_t> generation_ = std::make_shared<std::uint64_t>(0);
+#endif
+};
+
+// printArray from 13_raw_arrays.cpp: the size now travels with the pointer.
+void printArray(checked_span<const int> arr) {
+    for (int value : arr) {
+        std::cout << value << " ";
+    }
+    std::cout << std::endl;
+}
+
+// The two loops whose generated code is compared (see the file comment).
+__attribute__((noinline)) long long sumRaw(const int* data, std::size_t size) {
+    long long total = 0;
+    const int* end = data + size;
+    for (const int* p = data; p != end; ++p) {
+        total += *p;
+    }
+    return total;
+}
+
+__attribute__((noinline)) long long sumChecked(checked_span<const int> values) {
+    long long total = 0;
+    for (const int& v : values) {
+        total += v;
+    }
+    return total;
+}
+
+__attribute__((noinline)) long long sumIndexed(checked_span<const int> values) {
+    long long total = 0;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main() {
+    std::cout << "Configuration: " << (CHECKED_SPAN_CHECKS ? "debug (checks on)" : "release (checks off)")
+              << std::endl;
+
+    // 26_pointer_array_arithmetic.cpp, without the hardcoded 5.
+    int arr[] = {10, 20, 30, 40, 50};
+    checked_span<int> span(arr);
+    std::cout << "Array elements using a checked span: ";
+    printArray(span);
+
+#if CHECKED_SPAN_CHECKS
+    // Show the checks without aborting the program.
+    checkFailedHandler() = [](const char* what) { throw std::logic_error(what); };
+    auto expectFailure = [](const char* label, auto&& action) {
+        try {
+            action();
+            std::cout << "  " << label << ": not detected" << std::endl;
+        } catch (const std::logic_error& e) {
+            std::cout << "  " << label << ": detected (" << e.what() << ")" << std::endl;
+        }
+    };
+    std::cout << "Debug checks:" << std::endl;
+    expectFailure("arr[5]", [&] { return span[5]; });
+    expectFailure("*(end())", [&] { return *span.end(); });
+    expectFailure("begin() - 1", [&] { return span.begin() - 1; });
+
+    CheckedBuffer<int> buffer{1, 2, 3};
+    checked_span<int> view = buffer.span();
+    for (int i = 0; i < 100; ++i) {
+        buffer.push_back(i); // Reallocates at some point.
+    }
+    checked_span<int> copy = view;
+    checked_span<const int> constView = view;
+    expectFailure("use after reallocation", [&] { return view[0]; });
+    expectFailure("copied span after reallocation", [&] { return copy[0]; });
+    expectFailure("const span after reallocation", [&] { return constView[0]; });
+    expectFailure("iterator after reallocation", [&] { return *constView.begin(); });
+
+    // Spans taken after the reallocation are valid again.
+    checked_span<const int> fresh = buffer.span();
+    std::cout << "  fresh span after reallocation: " << fresh[0] << " ... " << fresh[fresh.size() - 1] << std::endl;
+
+    // Assignment replaces the storage; destruction frees it.
+    CheckedBuffer<int> other{7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24};
+    buffer = other;
+    expectFailure("span after assignment", [&] { return fresh[0]; });
+    checked_span<int> orphan;
+    {
+        CheckedBuffer<int> scoped{1, 2, 3};
+        orphan = scoped.span();
+    }
+    expectFailure("span after its buffer was destroyed", [&] { return orphan[0]; });
+    checkFailedHandler() = defaultCheckFailed;
+#endif
+
+    // Benchmark: raw pointer loop vs checked span loops over 32M ints.
+    std::vector<int> data(std::size_t{32} << 20);
+    std::iota(data.begin(), data.end(), 0);
+    long long a = 0, b = 0, c = 0;
+    double rawMs = bestOfMs(5, [&] { a = sumRaw(data.data(), data.size()); });
+    double spanMs = bestOfMs(5, [&] { b = sumChecked(checked_span<const int>(data)); });
+    double indexMs = bestOfMs(5, [&] { c = sumIndexed(checked_span<const int>(data)); });
+
+    std::cout << "Sum of " << data.size() << " ints (best of 5):" << std::endl;
+    std::cout << "  raw pointer loop:       " << rawMs << " ms (" << a << ")" << std::endl;
+    std::cout << "  checked_span range-for: " << spanMs << " ms (" << b << ")" << std::endl;
+    std::cout << "  checked_span indexing:  " << indexMs << " ms (" << c << ")" << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Why a span:
+ *    - A raw pointer does not know how many elements follow it, so every function that takes one
+ *      also needs a separate size, and nothing checks that the two agree.
+ *    - A span carries both, so `for (int v : span)` can never run past the end.
+ *
+ * 2. Debug vs release:
+ *    - The checks are compiled in only when NDEBUG is not defined, the same switch that controls
+ *      assert(). In release the class contains exactly a pointer and a size and its iterators are
+ *      raw pointers, so there is nothing left for the optimizer to remove.
+ *
+ * 3. Iterator invalidation:
+ *    - std::vector::push_back may move all elements to a new allocation. Pointers, references and
+ *      spans into the old allocation then dangle. CheckedBuffer counts reallocations and every span
+ *      remembers the count it was created with, so stale spans are caught on their next use.
+ *    - Assignment, moving from the buffer and destroying it also replace or free the storage, so
+ *      they bump the count too. The counter lives in a shared_ptr that the spans share, so a span
+ *      that outlives its buffer still reads a valid counter and reports the problem instead of
+ *      reading freed memory.
+ *
+ * Tips and Tricks:
+ * - Build and run your tests in the debug configuration; ship the release configuration.
+ * - In C++20 prefer std::span for the release type; this class mirrors its interface.
+ */
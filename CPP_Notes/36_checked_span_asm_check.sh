@@ -0,0 +1,54 @@
+#!/bin/sh
+# Checks the claim of 36_checked_span.cpp: in a release build (-DNDEBUG) sumChecked, which loops
+# over a checked_span, compiles to the same instructions as sumRaw, which loops over a raw pointer.
+#
+# Usage: sh 36_checked_span_asm_check.sh [compiler]   (default: $CXX, then g++)
+# Exit status 0 if the two functions match, 1 if they differ (the diff is printed).
+
+set -eu
+cxx=${1:-${CXX:-g++}}
+dir=$(dirname "$0")
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+"$cxx" -std=c++17 -O2 -DNDEBUG -S -o "$tmp/release.s" "$dir/36_checked_span.cpp"
+
+# Print the instructions of the function whose mangled name contains $2, normalized so that only
+# real differences remain: directives dropped, local labels renumbered in order of appearance, and
+# the operands of an equality compare (cmp followed by je/jne) sorted, since either order is the
+# same test.
+body() {
+    awk -v name="$2" '
+        !inside && /^_Z[^:]*:$/ && index($0, name) { inside = 1; next }
+        inside && /\.cfi_endproc/ { exit }
+        inside && !/^[ \t]*\./ { lines[n++] = $0 }
+        inside && /^\.L[0-9]+:/ { lines[n++] = $0 }
+        END {
+            for (i = 0; i < n; ++i) {
+                line = lines[i]
+                while (match(line, /\.L[0-9]+/)) {
+                    label = substr(line, RSTART, RLENGTH)
+                    if (!(label in renamed)) renamed[label] = "L" (++labels)
+                    line = substr(line, 1, RSTART - 1) renamed[label] substr(line, RSTART + RLENGTH)
+                }
+                if (line ~ /^\tcmp/ && i + 1 < n && lines[i + 1] ~ /^\tj(e|ne)\t/) {
+                    split(line, parts, /[\t]|, /)
+                    if (parts[3] > parts[4]) line = "\t" parts[2] "\t" parts[4] ", " parts[3]
+                }
+                print line
+            }
+        }' "$1"
+}
+
+body "$tmp/release.s" sumRaw > "$tmp/raw.txt"
+body "$tmp/release.s" sumChecked > "$tmp/checked.txt"
+if [ ! -s "$tmp/raw.txt" ] || [ ! -s "$tmp/checked.txt" ]; then
+    echo "sumRaw or sumChecked not found in the assembly" >&2
+    exit 1
+fi
+if diff -u "$tmp/raw.txt" "$tmp/checked.txt"; then
+    echo "OK: sumChecked compiles to the same $(wc -l < "$tmp/raw.txt") instructions and labels as sumRaw ($cxx, -O2 -DNDEBUG)"
+else
+    echo "sumChecked differs from sumRaw" >&2
+    exit 1
+fi
@@ -0,0 +1,349 @@
+/**
+ * @file 38_latency_histogram.cpp
+ * @brief Demonstrates a fixed-memory, log-linear latency histogram for measuring tail latency.
+ *
+ * Averages hide the slow calls. A function that usually takes 40 ns but sometimes 40 us has a fine mean
+ * and a terrible p99.9. To see the tail we need the whole distribution, and keeping every sample is
+ * too expensive for millions of calls.
+ *
+ * `LatencyHistogram` (in the style of HdrHistogram) keeps counts in buckets whose width grows with the
+ * value:
+ *
+ * - values below 128 ns get one bucket per nanosecond,
+ * - every power-of-two range above that is split into 64 equal buckets,
+ *
+ * so every recorded value is known to within 1/64 (about 1.6%) from 1 ns up to 2^63 ns, using one
+ * fixed array of 3776 counters. `record()` is a bit scan, a shift and an increment: O(1), no allocation.
+ *
+ * Histograms with the same layout merge by adding counters, so each thread records into its own
+ * instance (no locks, no shared cache lines) and `LatencyRecorder::collect()` merges them afterwards.
+ *
+ * The benchmark measures per-call latency of `executeFunction` (16_functions.cpp) from several threads
+ * and of `printValue` (18a_address&.cpp), prints percentiles up to p99.99, and exports the full
+ * distribution as CSV (shown, then deleted).
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Log-linear histogram of non-negative integer values (nanoseconds in this lesson).
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 7;                         // 128 linear buckets at the bottom
+    static constexpr std::uint64_t SubBucketCount = 1u << SubBucketBits;
+    static constexpr std::uint64_t HalfCount = SubBucketCount / 2;  // 64 buckets per power of two
+    static constexpr std::size_t BucketCount = (64 - SubBucketBits + 1) * HalfCount + HalfCount;
+
+    // O(1), never allocates.
+    void record(std::uint64_t value) {
+        ++counts_[bucketIndex(value)];
+        ++totalCount_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    // Add other's counts to this histogram.
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        totalCount_ += other.totalCount_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    std::uint64_t count() const { return totalCount_; }
+    std::uint64_t min() const { return totalCount_ ? min_ : 0; }
+    std::uint64_t max() const { return max_; }
+    double mean() const { return totalCount_ ? static_cast<double>(sum_) / totalCount_ : 0.0; }
+
+    // Smallest recorded value v such that `percentile` percent of all values are <= v
+    // (reported as the top of its bucket, clamped to the exact max).
+    std::uint64_t valueAtPercentile(double percentile) const {
+        if (totalCount_ == 0) {
+            return 0;
+        }
+        double clamped = std::min(std::max(percentile, 0.0), 100.0);
+        std::uint64_t target = static_cast<std::uint64_t>(clamped / 100.0 * totalCount_ + 0.5);
+        target = std::max<std::uint64_t>(target, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(highestEquivalentValue(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    // Print the usual summary line: count, mean and the tail percentiles.
+    void printSummary(std::ostream& out, const char* label) const {
+        out << std::left << std::setw(26) << label << std::right << " n=" << std::setw(9) << count()
+            << std::fixed << std::setprecision(1) << "  mean=" << std::setw(7) << mean();
+        const double percentiles[] = {50, 90, 99, 99.9, 99.99};
+        const char* names[] = {"p50", "p90", "p99", "p99.9", "p99.99"};
+        for (int i = 0; i < 5; ++i) {
+            out << "  " << names[i] << "=" << std::setw(6) << valueAtPercentile(percentiles[i]);
+        }
+        out << "  max=" << max() << " ns" << std::endl;
+    }
+
+    // Export the cumulative distribution as CSV: value, percentile, total count, 1/(1-percentile).
+    // The last column is what HdrHistogram plotters use as the x axis.
+    void exportCsv(std::ostream& out) const {
+        out << "value_ns,percentile,total_count,inverted_percentile\n";
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            if (counts_[i] == 0) {
+                continue;
+            }
+            seen += counts_[i];
+            double fraction = static_cast<double>(seen) / totalCount_;
+            out << std::min(highestEquivalentValue(i), max_) << ',' << std::setprecision(6) << fraction << ','
+                << seen << ',';
+            if (seen == totalCount_) {
+                out << "inf\n";
+            } else {
+                out << 1.0 / (1.0 - fraction) << '\n';
+            }
+        }
+    }
+
+    // Bucket layout, exposed for explanation.
+    static std::size_t bucketIndex(std::uint64_t value) {
+        if (value < SubBucketCount) {
+            return static_cast<std::size_t>(value); // Exact below 128.
+        }
+        // For value in [2^k, 2^(k+1)) with k >= 7, drop (k - 6) low bits so 64 <= value >> shift < 128.
+        int shift = (63 - __builtin_clzll(value)) - (SubBucketBits - 1);
+        return static_cast<std::size_t>(shift * HalfCount + (value >> shift));
+    }
+
+    static std::uint64_t lowestEquivalentValue(std::size_t index) {
+        if (index < SubBucketCount) {
+            return index;
+        }
+        std::uint64_t shift = index / HalfCount - 1;
+        return (index - shift * HalfCount) << shift;
+    }
+
+    static std::uint64_t highestEquivalentValue(std::size_t index) {
+        return index + 1 < BucketCount ? lowestEquivalentValue(index + 1) - 1 : UINT64_MAX;
+    }
+
+private:
+    std::array<std::uint64_t, BucketCount> counts_{};
+    std::uint64_t totalCount_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t min_ = UINT64_MAX;
+    std::uint64_t max_ = 0;
+};
+
+/**
+ * @brief Hands every thread its own histogram and merges them on demand.
+ *
+ * Histograms are owned by the recorder, not by the threads, so counts survive thread exit.
+ * Call collect() after the recording threads have finished (joined); recording is deliberately
+ * not synchronized so that it stays a plain increment.
+ */
+class LatencyRecorder {
+public:
+    // The calling thread's histogram for this recorder; created on first use. That first call per
+    // thread and recorder locks the mutex and allocates (the histogram, and possibly a bigger
+    // thread_local cache), so call it before the timed loop and keep the reference, as main does.
+    LatencyHistogram& local() {
+        // Keyed by id_, not by address: a new recorder may reuse the address of a destroyed one.
+        thread_local std::vector<std::pair<std::uint64_t, LatencyHistogram*>> cache;
+        for (auto& entry : cache) {
+            if (entry.first == id_) {
+                return *entry.second;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        histograms_.push_back(std::make_unique<LatencyHistogram>());
+        cache.emplace_back(id_, histograms_.back().get());
+        return *histograms_.back();
+    }
+
+    LatencyHistogram collect() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LatencyHistogram total;
+        for (const auto& h : histograms_) {
+            total.merge(*h);
+        }
+        return total;
+    }
+
+private:
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    const std::uint64_t id_ = nextId();
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<LatencyHistogram>> histograms_;
+};
+
+/**
+ * @brief Records the lifetime of the object, in nanoseconds, into a histogram.
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        histogram_.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// From 16_functions.cpp.
+void executeFunction(const std::function<void()>& func) {
+    func();
+}
+
+// From 18a_address&.cpp.
+void printValue(void* ptr, int type) {
+    if (type == 0) { // int
+        std::cout << "Integer value: " << *(static_cast<int*>(ptr)) << std::endl;
+    } else if (type == 1) { // double
+        std::cout << "Double value: " << *(static_cast<double*>(ptr)) << std::endl;
+    } else if (type == 2) { // char
+        std::cout << "Char value: " << *(static_cast<char*>(ptr)) << std::endl;
+    }
+}
+
+// Stream buffer that discards everything, so printValue can be timed without a terminal.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+int main() {
+    // The bucket layout: exact below 128, then 64 buckets per power of two.
+    std::cout << "Histogram: " << LatencyHistogram::BucketCount << " buckets, "
+              << sizeof(LatencyHistogram) / 1024 << " KB" << std::endl;
+    for (std::uint64_t v : {100ull, 1000ull, 1000000ull}) {
+        std::size_t i = LatencyHistogram::bucketIndex(v);
+        std::cout << "  " << v << " ns -> bucket " << i << " [" << LatencyHistogram::lowestEquivalentValue(i)
+                  << ", " << LatencyHistogram::highestEquivalentValue(i) << "]" << std::endl;
+    }
+
+    // Timer overhead: an empty region, so the other numbers can be read relative to it.
+    LatencyHistogram empty;
+    for (int i = 0; i < 1000000; ++i) {
+        ScopedLatency timer(empty);
+    }
+    std::cout << std::endl;
+    empty.printSummary(std::cout, "empty region (overhead)");
+
+    // executeFunction from several threads, each into its own histogram.
+    LatencyRecorder recorder;
+    const unsigned threadCount = std::max(2u, std::min(4u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&recorder] {
+            LatencyHistogram& histogram = recorder.local(); // Registers this thread outside the timed loop.
+            volatile long long sink = 0;
+            for (int i = 0; i < 500000; ++i) {
+                ScopedLatency timer(histogram);
+                executeFunction([&sink, i] { sink = sink + i; });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    LatencyHistogram functionLatency = recorder.collect();
+    functionLatency.printSummary(std::cout, "executeFunction (merged)");
+
+    // printValue into a discarded stream.
+    NullBuffer nullBuffer;
+    std::streambuf* original = std::cout.rdbuf(&nullBuffer);
+    LatencyHistogram printLatency;
+    int a = 10;
+    double b = 20.5;
+    char c = 'A';
+    for (int i = 0; i < 300000; ++i) {
+        ScopedLatency timer(printLatency);
+        switch (i % 3) {
+            case 0: printValue(&a, 0); break;
+            case 1: printValue(&b, 1); break;
+            default: printValue(&c, 2); break;
+        }
+    }
+    std::cout.rdbuf(original);
+    printLatency.printSummary(std::cout, "printValue");
+
+    // Export the full distribution for plotting; show its first rows and clean up.
+    const char* path = "latency_executeFunction.csv";
+    {
+        std::ofstream csv(path);
+        functionLatency.exportCsv(csv);
+    }
+    std::cout << std::endl << "First rows of " << path << ":" << std::endl;
+    std::ifstream csv(path);
+    std::string line;
+    for (int row = 0; row < 4 && std::getline(csv, line); ++row) {
+        std::cout << "  " << line << std::endl;
+    }
+    csv.close();
+    std::remove(path);
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Log-linear buckets:
+ *    - A value v >= 128 with highest set bit k is shifted right by (k - 6), leaving a number in
+ *      [64, 128). That number plus 64 times the shift is the bucket index. Below 128 the value is
+ *      its own index.
+ *    - The bucket width is always at most 1/64 of the value, so relative error stays bounded while
+ *      one array covers nanoseconds to centuries.
+ *
+ * 2. Per-thread recording:
+ *    - Each thread increments its own counters, so recording needs no atomics or locks. Because
+ *      histograms merge by addition, the merged result is exactly what one shared histogram would hold.
+ *
+ * 3. Percentiles:
+ *    - valueAtPercentile() walks the buckets until the running count reaches the requested fraction.
+ *      That is O(buckets), but it runs once per report, not once per sample.
+ *
+ * Tips and Tricks:
+ * - Do not subtract the timer overhead from samples; print the empty-region row next to the results.
+ * - Look at p99.9 and max; the mean of a latency distribution is rarely what users feel.
+ * - Plot the CSV with inverted_percentile on a log x axis to see the whole tail (remove the
+ *   std::remove call in main to keep the file).
+ * - Call LatencyRecorder::local() once per thread before timing: its first call allocates.
+ */
@@ -0,0 +1,376 @@
+/**
+ * @file 39_small_vector.cpp
+ * @brief Demonstrates a vector with inline storage that only allocates when it outgrows it.
+ *
+ * Every `std::vector<int>` in 13_raw_arrays.cpp and 14_loops.cpp holds five elements, and each one
+ * still costs a heap allocation and a free. When code creates millions of short-lived tiny vectors,
+ * the allocator dominates the run time.
+ *
+ * `small_vector<T, N>` keeps room for N elements inside the object itself:
+ *
+ * - while size() <= N the elements live in the inline buffer and no allocation happens,
+ * - the first push beyond the inline capacity moves everything to the heap, after which it
+ *   behaves like std::vector (geometric growth),
+ * - copy, move, assignment and destruction are correct in both states; a move from a heap-backed
+ *   vector steals the buffer, a move from an inline one moves the elements.
+ *
+ * It offers the std::vector operations used in this repository (push_back, emplace_back, indexing,
+ * iterators, size, reserve, resize, clear), so `printVector` and `rangeBasedForLoop` work unchanged
+ * once they accept any vector type.
+ *
+ * The benchmark counts heap allocations and times create/fill/sum/destroy cycles for 5-element
+ * vectors, and for 20-element vectors that spill to the heap.
+ *
+ * @note Compile with `-std=c++17 -O2`.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Global allocation counter, so the benchmark can show how many allocations each container makes.
+static std::size_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+/**
+ * @brief Sequence container with inline capacity N that spills to the heap when it overflows.
+ */
+template <typename T, std::size_t N>
+class small_vector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+
+    small_vector() = default;
+
+    small_vector(std::initializer_list<T> init) { assignRange(init.begin(), init.end()); }
+
+    explicit small_vector(size_type count, const T& value = T()) {
+        reserve(count);
+        std::uninitialized_fill_n(data_, count, value);
+        size_ = count;
+    }
+
+    small_vector(const small_vector& other) { assignRange(other.begin(), other.end()); }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        takeFrom(other);
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        if (this != &other) {
+            clear();
+            assignRange(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            releaseHeap();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~small_vector() {
+        clear();
+        releaseHeap();
+    }
+
+    // Element access.
+    T& operator[](size_type i) { return data_[i]; }
+    const T& operator[](size_type i) const { return data_[i]; }
+    T& at(size_type i) {
+        if (i >= size_) {
+            throw std::out_of_range("small_vector::at");
+        }
+        return data_[i];
+    }
+    const T& at(size_type i) const { return const_cast<small_vector*>(this)->at(i); }
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    // Iterators are plain pointers, as the storage is contiguous in either state.
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    // Capacity.
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    size_type capacity() const { return capacity_; }
+    bool is_inline() const { return data_ == inlineData(); }
+
+    void reserve(size_type newCapacity) {
+        if (newCapacity > capacity_) {
+            reallocate(newCapacity);
+        }
+    }
+
+    // Modifiers.
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            return growAndEmplace(std::forward<Args>(args)...);
+        }
+        T* slot = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void pop_back() {
+        --size_;
+        data_[size_].~T();
+    }
+
+    void resize(size_type count) {
+        if (count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+        } else {
+            reserve(count);
+            std::uninitialized_value_construct(data_ + size_, data_ + count);
+        }
+        size_ = count;
+    }
+
+    void clear() {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    friend bool operator==(const small_vector& a, const small_vector& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+
+private:
+    T* inlineData() { return reinterpret_cast<T*>(inline_); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(inline_); }
+
+    template <typename It>
+    void assignRange(It first, It last) {
+        reserve(static_cast<size_type>(std::distance(first, last)));
+        std::uninitialized_copy(first, last, data_);
+        size_ = static_cast<size_type>(std::distance(first, last));
+    }
+
+    // Precondition: *this is empty and inline.
+    void takeFrom(small_vector& other) {
+        if (other.is_inline()) {
+            std::uninitialized_move(other.begin(), other.end(), data_);
+            size_ = other.size_;
+            other.clear();
+        } else {
+            data_ = other.data_; // Steal the heap buffer.
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inlineData();
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+
+    void releaseHeap() {
+        if (!is_inline()) {
+            std::allocator<T>().deallocate(data_, capacity_);
+            data_ = inlineData();
+            capacity_ = N;
+        }
+    }
+
+    // Move (or copy, if moving could throw) the elements into a new heap buffer. If that throws,
+    // the new buffer is freed and *this is unchanged (strong guarantee).
+    void reallocate(size_type newCapacity) {
+        T* fresh = std::allocator<T>().allocate(newCapacity);
+        try {
+            relocate(fresh);
+        } catch (...) {
+            std::allocator<T>().deallocate(fresh, newCapacity);
+            throw;
+        }
+        adopt(fresh, newCapacity);
+    }
+
+    template <typename... Args>
+    T& growAndEmplace(Args&&... args) {
+        size_type newCapacity = std::max<size_type>(capacity_ * 2, 4);
+        T* fresh = std::allocator<T>().allocate(newCapacity);
+        T* element = nullptr;
+        try {
+            // Construct the new element first: args may refer to an element of *this.
+            element = ::new (static_cast<void*>(fresh + size_)) T(std::forward<Args>(args)...);
+            relocate(fresh);
+        } catch (...) {
+            if (element != nullptr) {
+                element->~T();
+            }
+            std::allocator<T>().deallocate(fresh, newCapacity);
+            throw;
+        }
+        adopt(fresh, newCapacity);
+        ++size_;
+        return data_[size_ - 1];
+    }
+
+    // If a copy or move throws, the uninitialized_* algorithms destroy what they had already built
+    // in `destination`, and the source elements are left untouched.
+    void relocate(T* destination) {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            std::uninitialized_move(data_, data_ + size_, destination);
+        } else {
+            std::uninitialized_copy(data_, data_ + size_, destination);
+        }
+        std::destroy(data_, data_ + size_);
+    }
+
+    void adopt(T* fresh, size_type newCapacity) {
+        releaseHeap();
+        data_ = fresh;
+        capacity_ = newCapacity;
+    }
+
+    T* data_ = inlineData();
+    size_type size_ = 0;
+    size_type capacity_ = N;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+// printVector from 13_raw_arrays.cpp, accepting any vector type.
+template <typename Vector>
+void printVector(const Vector& vec) {
+    for (const auto& elem : vec) {
+        std::cout << elem << " ";
+    }
+    std::cout << std::endl;
+}
+
+// rangeBasedForLoop from 14_loops.cpp, accepting any vector type.
+template <typename Vector>
+void rangeBasedForLoop(const Vector& vec) {
+    std::cout << "Range-based for loop: ";
+    for (const int& value : vec) {
+        std::cout << value << " ";
+    }
+    std::cout << std::endl;
+}
+
+// Build, fill and sum `iterations` short-lived vectors of `count` ints.
+template <typename Vector>
+long long churn(std::size_t iterations, int count) {
+    long long total = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        Vector vec;
+        for (int k = 0; k < count; ++k) {
+            vec.push_back(static_cast<int>(i) + k);
+        }
+        for (int value : vec) {
+            total += value;
+        }
+    }
+    return total;
+}
+
+template <typename Vector>
+void benchmark(const char* name, std::size_t iterations, int count) {
+    std::size_t before = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    long long total = churn<Vector>(iterations, count);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << ns / iterations << " ns per vector, "
+              << static_cast<double>(g_allocations - before) / iterations << " allocations per vector"
+              << " (checksum " << total << ")" << std::endl;
+}
+
+int main() {
+    // Drop-in use with the existing helpers.
+    small_vector<int, 8> numbers = {1, 2, 3, 4, 5};
+    std::cout << "Elements of small_vector: ";
+    printVector(numbers);
+    rangeBasedForLoop(numbers);
+    std::cout << "Inline: " << std::boolalpha << numbers.is_inline() << ", capacity " << numbers.capacity()
+              << std::endl;
+
+    // Copy and move in both states.
+    small_vector<std::string, 2> names = {"alpha", "beta"};
+    small_vector<std::string, 2> copy = names;
+    small_vector<std::string, 2> moved = std::move(copy);
+    names.push_back("gamma"); // Spills to the heap.
+    small_vector<std::string, 2> stolen = std::move(names);
+    std::cout << "Copied then moved (inline): ";
+    printVector(moved);
+    std::cout << "Moved from heap-backed vector: ";
+    printVector(stolen);
+    std::cout << "Heap buffer stolen: " << !stolen.is_inline() << ", source now empty: " << names.empty()
+              << std::endl;
+    stolen.push_back(stolen[0]); // Argument aliases an element while the buffer may grow.
+    std::cout << "After push_back(stolen[0]): ";
+    printVector(stolen);
+
+    // Benchmarks.
+    const std::size_t iterations = 5000000;
+    std::cout << std::endl << "Five-element vectors (" << iterations << " iterations):" << std::endl;
+    benchmark<std::vector<int>>("std::vector<int>      ", iterations, 5);
+    benchmark<small_vector<int, 8>>("small_vector<int, 8>  ", iterations, 5);
+
+    std::cout << "Twenty-element vectors (spill to the heap):" << std::endl;
+    benchmark<std::vector<int>>("std::vector<int>      ", iterations / 5, 20);
+    benchmark<small_vector<int, 8>>("small_vector<int, 8>  ", iterations / 5, 20);
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Inline storage:
+ *    - `alignas(T) unsigned char inline_[N * sizeof(T)]` is raw memory inside the object. Elements are
+ *      created in it with placement new and destroyed explicitly, so unused slots cost no constructors.
+ *    - data_ points either at that buffer or at a heap buffer; all other code just uses data_.
+ *
+ * 2. Moves:
+ *    - A heap-backed vector is moved by taking its pointer, like std::vector.
+ *    - An inline vector cannot give away its buffer (it is part of the object), so its elements are
+ *      moved one by one. Moving a small_vector is therefore O(size) while inline.
+ *
+ * 3. Growth:
+ *    - When full, a new buffer of twice the capacity is allocated. The new element is constructed
+ *      before the old ones are moved, so `v.push_back(v[0])` stays valid.
+ *
+ * Tips and Tricks:
+ * - Pick N from real size distributions; an oversized N makes every object (and every move) larger.
+ * - sizeof(small_vector<int, 8>) is 56 bytes, against 24 for std::vector<int>.
+ */
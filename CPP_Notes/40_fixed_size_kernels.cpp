@@ -0,0 +1,337 @@
+/**
+ * @file 40_fixed_size_kernels.cpp
+ * @brief Demonstrates compile-time unrolled kernels for small fixed-size std::array values.
+ *
+ * `printStdArray<std::size_t N>` in 13_raw_arrays.cpp knows N at compile time but still loops over the
+ * array like a runtime container. For millions of small arrays (3D coordinates, 8- or 16-wide feature
+ * vectors) the loop has two costs:
+ *
+ * - a running total `s += a[i]` is a chain of N dependent additions, so the CPU cannot overlap them;
+ * - for floating point the compiler may not reorder the additions, so it cannot fix that for us.
+ *
+ * The kernels in namespace `fixed` use `std::index_sequence` to expand every element access at compile
+ * time. Reductions (sum, dot, min, max) combine the elements as a balanced tree, so the dependency chain
+ * is log2(N) long instead of N. Elementwise operations become straight-line code, and serialization
+ * copies a compile-time number of bytes.
+ * Above `UnrollLimit` elements the kernels fall back to a loop with four independent accumulators,
+ * which the compiler vectorizes.
+ *
+ * The benchmark runs each kernel over a million arrays for N = 3, 4, 8, 16 and 64 and compares it with
+ * the plain range-for version.
+ *
+ * @note Compile with `-std=c++17 -O2`. A tree-ordered float sum can differ from the left-to-right sum
+ * in the last bits.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// printStdArray from 13_raw_arrays.cpp.
+template <std::size_t N>
+void printStdArray(const std::array<int, N>& arr) {
+    for (const auto& elem : arr) {
+        std::cout << elem << " ";
+    }
+    std::cout << std::endl;
+}
+
+namespace fixed {
+
+// Arrays up to this size are fully unrolled; larger ones use a loop.
+constexpr std::size_t UnrollLimit = 16;
+
+// Combine arr[Begin, Begin + Count) with op as a balanced tree, fully expanded at compile time.
+template <std::size_t Begin, std::size_t Count, typename T, std::size_t N, typename Op>
+constexpr T treeReduce(const std::array<T, N>& arr, Op op) {
+    if constexpr (Count == 1) {
+        return arr[Begin];
+    } else {
+        constexpr std::size_t Half = Count / 2;
+        return op(treeReduce<Begin, Half>(arr, op), treeReduce<Begin + Half, Count - Half>(arr, op));
+    }
+}
+
+// Fallback for large N: four independent accumulators, then combine.
+template <typename T, std::size_t N, typename Op>
+T loopReduce(const std::array<T, N>& arr, Op op) {
+    T acc[4] = {arr[0], arr[1], arr[2], arr[3]};
+    std::size_t i = 4;
+    for (; i + 4 <= N; i += 4) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            acc[k] = op(acc[k], arr[i + k]);
+        }
+    }
+    for (; i < N; ++i) {
+        acc[0] = op(acc[0], arr[i]);
+    }
+    return op(op(acc[0], acc[1]), op(acc[2], acc[3]));
+}
+
+template <typename T, std::size_t N, typename Op>
+constexpr T reduce(const std::array<T, N>& arr, Op op) {
+    static_assert(N > 0, "reducing an empty array");
+    if constexpr (N <= UnrollLimit || N < 4) {
+        return treeReduce<0, N>(arr, op);
+    } else {
+        return loopReduce(arr, op);
+    }
+}
+
+// Apply op to each pair of elements; the pack expansion writes every element explicitly.
+template <typename T, std::size_t N, typename Op, std::size_t... I>
+constexpr std::array<T, N> zipWith(const std::array<T, N>& a, const std::array<T, N>& b, Op op,
+                                   std::index_sequence<I...>) {
+    return {{op(a[I], b[I])...}};
+}
+
+template <typename T, std::size_t N, typename Op>
+constexpr std::array<T, N> zipWith(const std::array<T, N>& a, const std::array<T, N>& b, Op op) {
+    if constexpr (N <= UnrollLimit) {
+        return zipWith(a, b, op, std::make_index_sequence<N>{});
+    } else {
+        std::array<T, N> out{};
+        for (std::size_t i = 0; i < N; ++i) {
+            out[i] = op(a[i], b[i]);
+        }
+        return out;
+    }
+}
+
+struct Plus {
+    template <typename T>
+    constexpr T operator()(T x, T y) const { return x + y; }
+};
+struct Minus {
+    template <typename T>
+    constexpr T operator()(T x, T y) const { return x - y; }
+};
+struct Times {
+    template <typename T>
+    constexpr T operator()(T x, T y) const { return x * y; }
+};
+struct Min {
+    template <typename T>
+    constexpr T operator()(T x, T y) const { return y < x ? y : x; }
+};
+struct Max {
+    template <typename T>
+    constexpr T operator()(T x, T y) const { return x < y ? y : x; }
+};
+
+template <typename T, std::size_t N>
+constexpr T sum(const std::array<T, N>& arr) { return reduce(arr, Plus{}); }
+
+template <typename T, std::size_t N>
+constexpr T min(const std::array<T, N>& arr) { return reduce(arr, Min{}); }
+
+template <typename T, std::size_t N>
+constexpr T max(const std::array<T, N>& arr) { return reduce(arr, Max{}); }
+
+template <typename T, std::size_t N>
+constexpr T dot(const std::array<T, N>& a, const std::array<T, N>& b) {
+    if constexpr (N <= UnrollLimit) {
+        return sum(zipWith(a, b, Times{})); // The temporary array is optimized away.
+    } else {
+        // Fused multiply and add, without the N-element temporary.
+        T acc[4] = {};
+        std::size_t i = 0;
+        for (; i + 4 <= N; i += 4) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                acc[k] += a[i + k] * b[i + k];
+            }
+        }
+        for (; i < N; ++i) {
+            acc[0] += a[i] * b[i];
+        }
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+}
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N> add(const std::array<T, N>& a, const std::array<T, N>& b) { return zipWith(a, b, Plus{}); }
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N> sub(const std::array<T, N>& a, const std::array<T, N>& b) { return zipWith(a, b, Minus{}); }
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N> mul(const std::array<T, N>& a, const std::array<T, N>& b) { return zipWith(a, b, Times{}); }
+
+// Serialization in native byte order. The byte count is a compile-time constant, so memcpy
+// becomes a few fixed-size moves instead of a library call.
+template <typename T, std::size_t N>
+constexpr std::size_t serializedSize = N * sizeof(T);
+
+template <typename T, std::size_t N>
+void serialize(const std::array<T, N>& arr, unsigned char* out) {
+    static_assert(std::is_trivially_copyable_v<T>, "serialize needs trivially copyable elements");
+    std::memcpy(out, arr.data(), serializedSize<T, N>);
+}
+
+template <typename T, std::size_t N>
+std::array<T, N> deserialize(const unsigned char* in) {
+    std::array<T, N> arr;
+    std::memcpy(arr.data(), in, serializedSize<T, N>);
+    return arr;
+}
+
+// printStdArray with the loop expanded by a fold expression.
+template <std::size_t N, std::size_t... I>
+void printStdArray(const std::array<int, N>& arr, std::index_sequence<I...>) {
+    ((std::cout << arr[I] << " "), ...);
+    std::cout << std::endl;
+}
+
+template <std::size_t N>
+void printStdArray(const std::array<int, N>& arr) {
+    printStdArray(arr, std::make_index_sequence<N>{});
+}
+
+} // namespace fixed
+
+// The generic versions: a plain range-for, exactly as one would write it for a vector.
+namespace generic {
+
+template <typename T, std::size_t N>
+T sum(const std::array<T, N>& arr) {
+    T total = 0;
+    for (const T& value : arr) {
+        total += value;
+    }
+    return total;
+}
+
+template <typename T, std::size_t N>
+T dot(const std::array<T, N>& a, const std::array<T, N>& b) {
+    T total = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+template <typename T, std::size_t N>
+T max(const std::array<T, N>& arr) {
+    T best = arr[0];
+    for (const T& value : arr) {
+        best = std::max(best, value);
+    }
+    return best;
+}
+
+} // namespace generic
+
+// Compile-time checks: the kernels are constexpr.
+static_assert(fixed::sum(std::array<int, 5>{1, 2, 3, 4, 5}) == 15);
+static_assert(fixed::dot(std::array<int, 3>{1, 2, 3}, std::array<int, 3>{4, 5, 6}) == 32);
+static_assert(fixed::max(std::array<int, 4>{3, 9, 2, 7}) == 9);
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+// Run sum, dot and max over `count` arrays of N floats, generic vs fixed.
+template <std::size_t N>
+void benchmarkSize(std::size_t count) {
+    using Array = std::array<float, N>;
+    std::vector<Array> a(count), b(count);
+    std::mt19937 rng(static_cast<unsigned>(N));
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t k = 0; k < N; ++k) {
+            a[i][k] = dist(rng);
+            b[i][k] = dist(rng);
+        }
+    }
+
+    volatile float sink = 0;
+    auto run = [&](auto kernel) {
+        return bestOfMs(5, [&] {
+            float total = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                total += kernel(a[i], b[i]);
+            }
+            sink = total;
+        });
+    };
+
+    double genericSum = run([](const Array& x, const Array&) { return generic::sum(x); });
+    double fixedSum = run([](const Array& x, const Array&) { return fixed::sum(x); });
+    double genericDot = run([](const Array& x, const Array& y) { return generic::dot(x, y); });
+    double fixedDot = run([](const Array& x, const Array& y) { return fixed::dot(x, y); });
+    double genericMax = run([](const Array& x, const Array&) { return generic::max(x); });
+    double fixedMax = run([](const Array& x, const Array&) { return fixed::max(x); });
+
+    std::cout << "  N=" << N << (N < 10 ? " " : "") << "  sum " << genericSum << " -> " << fixedSum << " ms"
+              << "   dot " << genericDot << " -> " << fixedDot << " ms"
+              << "   max " << genericMax << " -> " << fixedMax << " ms" << std::endl;
+}
+
+int main() {
+    std::array<int, 5> stdArray = {1, 2, 3, 4, 5};
+    std::cout << "Elements of std::array (loop): ";
+    printStdArray(stdArray);
+    std::cout << "Elements of std::array (unrolled): ";
+    fixed::printStdArray(stdArray);
+
+    std::array<int, 5> other = {5, 4, 3, 2, 1};
+    std::cout << "sum=" << fixed::sum(stdArray) << " dot=" << fixed::dot(stdArray, other)
+              << " min=" << fixed::min(stdArray) << " max=" << fixed::max(stdArray) << std::endl;
+    std::cout << "add: ";
+    fixed::printStdArray(fixed::add(stdArray, other));
+    std::cout << "mul: ";
+    fixed::printStdArray(fixed::mul(stdArray, other));
+
+    unsigned char bytes[fixed::serializedSize<int, 5>];
+    fixed::serialize(stdArray, bytes);
+    std::cout << "Round trip through " << sizeof(bytes) << " bytes: ";
+    fixed::printStdArray(fixed::deserialize<int, 5>(bytes));
+
+    // Benchmark: generic -> fixed, best of 5, over 1M arrays (smaller count for N=64).
+    std::cout << std::endl << "Generic range-for -> fixed kernels (float):" << std::endl;
+    benchmarkSize<3>(1000000);
+    benchmarkSize<4>(1000000);
+    benchmarkSize<8>(1000000);
+    benchmarkSize<16>(1000000);
+    benchmarkSize<64>(250000);
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Index sequences:
+ *    - std::make_index_sequence<N> is the type index_sequence<0, 1, ..., N-1>. A function that takes
+ *      it as a parameter pack `I...` can write `arr[I]...` and get one expression per element.
+ *
+ * 2. Tree reductions:
+ *    - `((a0 + a1) + a2) + a3` needs three additions one after another. `(a0 + a1) + (a2 + a3)` needs
+ *      two rounds, and the two additions of the first round run in parallel. For N = 16 the chain drops
+ *      from 15 additions to 4.
+ *    - For integers the compiler can reassociate by itself, so gains are largest for float and double.
+ *
+ * 3. Large N:
+ *    - Full unrolling of very long arrays bloats code and the instruction cache. Above UnrollLimit a
+ *      loop with four accumulators keeps the parallelism with a small body.
+ *
+ * Tips and Tricks:
+ * - The kernels are constexpr, so they also work in static_assert and constant expressions.
+ * - Check the generated code with `-S`; fully unrolled kernels should contain no loops.
+ */
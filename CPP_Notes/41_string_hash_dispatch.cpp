@@ -0,0 +1,385 @@
+/**
+ * @file 41_string_hash_dispatch.cpp
+ * @brief Demonstrates compile-time string hashing for O(1) dispatch on string commands.
+ *
+ * 7_string_usage.cpp compares `const char*`, `std::string` and `std::string_view`. A common next step
+ * is routing: an incoming command string is compared against dozens of literals,
+ *
+ *     if (cmd == "start") ... else if (cmd == "stop") ... else if ...
+ *
+ * and a command near the end of the chain pays for every comparison before it.
+ *
+ * This program shows two O(1) alternatives built at compile time:
+ *
+ * - `"name"_h` is a constexpr FNV-1a hash, usable as a `case` label. The switch jumps straight to one
+ *   candidate and a single `==` confirms it (two different strings can share a hash). If two labels
+ *   ever collide, the duplicate `case` is a compile error.
+ * - `PerfectHashTable` is built by a constexpr function from a list of (name, handler) pairs. It
+ *   splits the keys into small buckets and searches a seed per bucket so that every key gets its own
+ *   slot; a lookup is one hash, two array reads and one string comparison, with no probing and no
+ *   allocation. It builds tables of up to 254 keys; main() also builds one with 64.
+ *
+ * Both are compared with an if/else chain and `std::unordered_map<std::string, Handler>`, on a random
+ * mix of known and unknown commands and on commands from the end of the chain. With only 16 names the
+ * chain holds up on the random mix (most comparisons fail on the length check); its cost grows with
+ * the number of names and the position of the name, while the hashed versions stay flat.
+ *
+ * @note Compile with `-std=c++17 -O2`.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 64-bit FNV-1a: xor each byte in, then multiply by the FNV prime.
+constexpr std::uint64_t fnv1a(std::string_view text) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// "name"_h is the FNV-1a hash of "name", computed by the compiler.
+constexpr std::uint64_t operator""_h(const char* text, std::size_t length) {
+    return fnv1a(std::string_view(text, length));
+}
+
+static_assert("start"_h != "stop"_h);
+
+constexpr std::size_t nextPowerOfTwo(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+        p *= 2;
+    }
+    return p;
+}
+
+/**
+ * @brief Immutable string -> Value map with one slot per key, built at compile time.
+ *
+ * Hash-and-displace (CHD): each key's FNV-1a hash picks one of `Buckets` small buckets (about two
+ * keys each), and every bucket gets its own seed such that `slotOf(hash, seed)` sends its keys to
+ * slots no other key uses. Buckets are placed largest first, while most of the `Slots` (next power
+ * of two >= 2 * K) are still free, so each needs only a few tries. One global seed for all keys
+ * would instead succeed with probability about exp(-K^2 / (2 * Slots)), which stops compiling
+ * within the constexpr step limit at a few dozen keys.
+ */
+template <typename Value, std::size_t K>
+class PerfectHashTable {
+public:
+    static constexpr std::size_t Slots = nextPowerOfTwo(2 * K);
+    static constexpr std::size_t Buckets = nextPowerOfTwo((K + 1) / 2);
+
+    constexpr explicit PerfectHashTable(const std::array<std::pair<std::string_view, Value>, K>& entries)
+        : entries_(entries) {
+        std::array<std::uint64_t, K> hashes{}; // Each key is hashed once, not once per seed tried.
+        std::array<std::size_t, Buckets> bucketSize{};
+        for (std::size_t i = 0; i < K; ++i) {
+            hashes[i] = fnv1a(entries_[i].first);
+            ++bucketSize[bucketOf(hashes[i])];
+        }
+        // Largest buckets first (insertion sort: std::sort is not constexpr in C++17).
+        std::array<std::size_t, Buckets> order{};
+        for (std::size_t b = 0; b < Buckets; ++b) {
+            std::size_t at = b;
+            for (; at > 0 && bucketSize[order[at - 1]] < bucketSize[b]; --at) {
+                order[at] = order[at - 1];
+            }
+            order[at] = b;
+        }
+        for (std::size_t b : order) {
+            if (bucketSize[b] != 0 && !placeBucket(b, hashes)) {
+                throw std::logic_error("no perfect hash seed found"); // In a constant expression: compile error.
+            }
+        }
+    }
+
+    // Returns nullptr if key is not in the table.
+    constexpr const Value* find(std::string_view key) const {
+        std::uint64_t hash = fnv1a(key);
+        std::uint8_t slot = slots_[slotOf(hash, seeds_[bucketOf(hash)])];
+        if (slot == 0 || entries_[slot - 1].first != key) {
+            return nullptr;
+        }
+        return &entries_[slot - 1].second;
+    }
+
+    // The largest seed any bucket needed: how hard the search was.
+    constexpr std::uint16_t maxSeed() const {
+        std::uint16_t largest = 0;
+        for (std::uint16_t seed : seeds_) {
+            largest = std::max(largest, seed);
+        }
+        return largest;
+    }
+
+private:
+    static_assert(K > 0 && K < 255, "slot indices are stored in one byte");
+
+    // Final mixing step of splitmix64, so a small change of the input changes every output bit.
+    static constexpr std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // The bucket uses the high half of the mixed hash, the slot (for seed 0) the low half.
+    static constexpr std::size_t bucketOf(std::uint64_t hash) {
+        return static_cast<std::size_t>(mix(hash) >> 32) & (Buckets - 1);
+    }
+
+    static constexpr std::size_t slotOf(std::uint64_t hash, std::uint64_t seed) {
+        return static_cast<std::size_t>(mix(hash + seed * 0x9E3779B97F4A7C15ull)) & (Slots - 1);
+    }
+
+    // Finds a seed that puts every key of `bucket` into a distinct free slot, and claims the slots.
+    constexpr bool placeBucket(std::size_t bucket, const std::array<std::uint64_t, K>& hashes) {
+        std::array<std::size_t, K> keys{};
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < K; ++i) {
+            if (bucketOf(hashes[i]) == bucket) {
+                keys[count++] = i;
+            }
+        }
+        for (std::uint32_t seed = 0; seed <= UINT16_MAX; ++seed) {
+            std::array<std::size_t, K> chosen{};
+            std::size_t placed = 0;
+            for (; placed < count; ++placed) {
+                std::size_t s = slotOf(hashes[keys[placed]], seed);
+                bool taken = slots_[s] != 0;
+                for (std::size_t j = 0; j < placed && !taken; ++j) {
+                    taken = chosen[j] == s;
+                }
+                if (taken) {
+                    break; // Collision: try the next seed.
+                }
+                chosen[placed] = s;
+            }
+            if (placed == count) {
+                for (std::size_t j = 0; j < count; ++j) {
+                    slots_[chosen[j]] = static_cast<std::uint8_t>(keys[j] + 1);
+                }
+                seeds_[bucket] = static_cast<std::uint16_t>(seed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::array<std::pair<std::string_view, Value>, K> entries_;
+    std::array<std::uint8_t, Slots> slots_{};     // 0 = empty, otherwise entry index + 1
+    std::array<std::uint16_t, Buckets> seeds_{};  // Displacement seed of each bucket
+};
+
+// Handlers. Each one does a little distinct work so the compiler cannot merge them.
+using Handler = int (*)(int);
+
+template <int Id>
+int handle(int arg) {
+    return arg * 31 + Id;
+}
+
+constexpr int unknownCommand = -1;
+
+// 1. if/else chain of string comparisons.
+int dispatchIfElse(std::string_view cmd, int arg) {
+    if (cmd == "start") return handle<0>(arg);
+    else if (cmd == "stop") return handle<1>(arg);
+    else if (cmd == "pause") return handle<2>(arg);
+    else if (cmd == "resume") return handle<3>(arg);
+    else if (cmd == "status") return handle<4>(arg);
+    else if (cmd == "reload") return handle<5>(arg);
+    else if (cmd == "get") return handle<6>(arg);
+    else if (cmd == "set") return handle<7>(arg);
+    else if (cmd == "delete") return handle<8>(arg);
+    else if (cmd == "list") return handle<9>(arg);
+    else if (cmd == "subscribe") return handle<10>(arg);
+    else if (cmd == "unsubscribe") return handle<11>(arg);
+    else if (cmd == "publish") return handle<12>(arg);
+    else if (cmd == "flush") return handle<13>(arg);
+    else if (cmd == "stats") return handle<14>(arg);
+    else if (cmd == "shutdown") return handle<15>(arg);
+    return unknownCommand;
+}
+
+// 2. switch on the compile-time hash, confirmed by one comparison.
+int dispatchSwitch(std::string_view cmd, int arg) {
+    switch (fnv1a(cmd)) {
+        case "start"_h: if (cmd == "start") return handle<0>(arg); break;
+        case "stop"_h: if (cmd == "stop") return handle<1>(arg); break;
+        case "pause"_h: if (cmd == "pause") return handle<2>(arg); break;
+        case "resume"_h: if (cmd == "resume") return handle<3>(arg); break;
+        case "status"_h: if (cmd == "status") return handle<4>(arg); break;
+        case "reload"_h: if (cmd == "reload") return handle<5>(arg); break;
+        case "get"_h: if (cmd == "get") return handle<6>(arg); break;
+        case "set"_h: if (cmd == "set") return handle<7>(arg); break;
+        case "delete"_h: if (cmd == "delete") return handle<8>(arg); break;
+        case "list"_h: if (cmd == "list") return handle<9>(arg); break;
+        case "subscribe"_h: if (cmd == "subscribe") return handle<10>(arg); break;
+        case "unsubscribe"_h: if (cmd == "unsubscribe") return handle<11>(arg); break;
+        case "publish"_h: if (cmd == "publish") return handle<12>(arg); break;
+        case "flush"_h: if (cmd == "flush") return handle<13>(arg); break;
+        case "stats"_h: if (cmd == "stats") return handle<14>(arg); break;
+        case "shutdown"_h: if (cmd == "shutdown") return handle<15>(arg); break;
+    }
+    return unknownCommand;
+}
+
+// 3. Perfect hash table, built entirely by the compiler.
+constexpr PerfectHashTable<Handler, 16> routes({{
+    {"start", handle<0>},      {"stop", handle<1>},         {"pause", handle<2>},    {"resume", handle<3>},
+    {"status", handle<4>},     {"reload", handle<5>},       {"get", handle<6>},      {"set", handle<7>},
+    {"delete", handle<8>},     {"list", handle<9>},         {"subscribe", handle<10>}, {"unsubscribe", handle<11>},
+    {"publish", handle<12>},   {"flush", handle<13>},       {"stats", handle<14>},   {"shutdown", handle<15>},
+}});
+
+static_assert(routes.find("publish") != nullptr);
+static_assert(routes.find("restart") == nullptr);
+
+int dispatchPerfectHash(std::string_view cmd, int arg) {
+    const Handler* handler = routes.find(cmd);
+    return handler ? (*handler)(arg) : unknownCommand;
+}
+
+// "Dozens of literals": 64 command names of a key-value server, mapped to their index.
+constexpr std::array<std::pair<std::string_view, int>, 64> serverCommandList{{
+    {"append", 0},    {"auth", 1},      {"bgsave", 2},    {"bitcount", 3},  {"blpop", 4},      {"brpop", 5},
+    {"client", 6},    {"config", 7},    {"dbsize", 8},    {"decr", 9},      {"decrby", 10},    {"del", 11},
+    {"discard", 12},  {"dump", 13},     {"echo", 14},     {"eval", 15},     {"exec", 16},      {"exists", 17},
+    {"expire", 18},   {"flushall", 19}, {"flushdb", 20},  {"get", 21},      {"getbit", 22},    {"getrange", 23},
+    {"getset", 24},   {"hdel", 25},     {"hexists", 26},  {"hget", 27},     {"hgetall", 28},   {"hincrby", 29},
+    {"hkeys", 30},    {"hlen", 31},     {"hmget", 32},    {"hmset", 33},    {"hset", 34},      {"hvals", 35},
+    {"incr", 36},     {"incrby", 37},   {"info", 38},     {"keys", 39},     {"lindex", 40},    {"llen", 41},
+    {"lpop", 42},     {"lpush", 43},    {"lrange", 44},   {"lrem", 45},     {"lset", 46},      {"mget", 47},
+    {"monitor", 48},  {"move", 49},     {"mset", 50},     {"multi", 51},    {"persist", 52},   {"ping", 53},
+    {"publish", 54},  {"rename", 55},   {"rpop", 56},     {"rpush", 57},    {"sadd", 58},      {"save", 59},
+    {"scard", 60},    {"select", 61},   {"smembers", 62}, {"subscribe", 63},
+}};
+constexpr PerfectHashTable<int, 64> serverCommands(serverCommandList);
+
+static_assert([] {
+    for (const auto& entry : serverCommandList) {
+        const int* found = serverCommands.find(entry.first);
+        if (found == nullptr || *found != entry.second) {
+            return false;
+        }
+    }
+    return serverCommands.find("restart") == nullptr;
+}());
+
+// 4. std::unordered_map, filled at startup.
+const std::unordered_map<std::string, Handler>& handlerMap() {
+    static const std::unordered_map<std::string, Handler> map = {
+        {"start", handle<0>},    {"stop", handle<1>},       {"pause", handle<2>},      {"resume", handle<3>},
+        {"status", handle<4>},   {"reload", handle<5>},     {"get", handle<6>},        {"set", handle<7>},
+        {"delete", handle<8>},   {"list", handle<9>},       {"subscribe", handle<10>}, {"unsubscribe", handle<11>},
+        {"publish", handle<12>}, {"flush", handle<13>},     {"stats", handle<14>},     {"shutdown", handle<15>},
+    };
+    return map;
+}
+
+int dispatchUnorderedMap(const std::string& cmd, int arg) {
+    auto it = handlerMap().find(cmd);
+    return it != handlerMap().end() ? it->second(arg) : unknownCommand;
+}
+
+template <typename Fn>
+double timeNsPerCall(const std::vector<std::string>& commands, Fn&& dispatch, long long& checksum) {
+    double best = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+        long long total = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < commands.size(); ++i) {
+            total += dispatch(commands[i], static_cast<int>(i));
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / commands.size());
+        checksum = total;
+    }
+    return best;
+}
+
+int main() {
+    std::cout << "\"start\"_h = 0x" << std::hex << "start"_h << std::dec << std::endl;
+    std::cout << "Perfect hash: 16 keys in " << routes.Slots << " slots, " << routes.Buckets
+              << " buckets, largest seed " << routes.maxSeed() << std::endl;
+    std::cout << "Perfect hash: 64 keys in " << serverCommands.Slots << " slots, " << serverCommands.Buckets
+              << " buckets, largest seed " << serverCommands.maxSeed() << std::endl;
+    for (const char* cmd : {"stop", "shutdown", "restart"}) {
+        std::cout << "  " << cmd << " -> " << dispatchSwitch(cmd, 1) << " (switch), "
+                  << dispatchPerfectHash(cmd, 1) << " (perfect hash)" << std::endl;
+    }
+
+    // Workload: 1M commands, uniformly spread over the 16 known names plus 10% unknown ones.
+    const char* known[] = {"start", "stop", "pause", "resume", "status", "reload", "get", "set",
+                           "delete", "list", "subscribe", "unsubscribe", "publish", "flush", "stats", "shutdown"};
+    const char* unknown[] = {"restart", "getx", "STOP", "statistics"};
+    std::mt19937 rng(7);
+    std::vector<std::string> commands(1000000);
+    for (auto& cmd : commands) {
+        cmd = rng() % 10 == 0 ? unknown[rng() % 4] : known[rng() % 16];
+    }
+
+    // Second workload: only the last four names of the chain, the if/else worst case.
+    std::vector<std::string> lateCommands(commands.size());
+    for (auto& cmd : lateCommands) {
+        cmd = known[12 + rng() % 4];
+    }
+
+    for (const auto* workload : {&commands, &lateCommands}) {
+        long long c1 = 0, c2 = 0, c3 = 0, c4 = 0;
+        auto ifElse = [](const std::string& c, int a) { return dispatchIfElse(c, a); };
+        auto map = [](const std::string& c, int a) { return dispatchUnorderedMap(c, a); };
+        auto sw = [](const std::string& c, int a) { return dispatchSwitch(c, a); };
+        auto perfect = [](const std::string& c, int a) { return dispatchPerfectHash(c, a); };
+
+        std::cout << std::endl
+                  << (workload == &commands ? "All commands, 10% unknown" : "Last four commands of the chain")
+                  << " (" << workload->size() << " calls, best of 5):" << std::endl;
+        std::cout << "  if/else chain:      " << timeNsPerCall(*workload, ifElse, c1) << " ns/call" << std::endl;
+        std::cout << "  std::unordered_map: " << timeNsPerCall(*workload, map, c2) << " ns/call" << std::endl;
+        std::cout << "  switch on _h:       " << timeNsPerCall(*workload, sw, c3) << " ns/call" << std::endl;
+        std::cout << "  perfect hash table: " << timeNsPerCall(*workload, perfect, c4) << " ns/call" << std::endl;
+        std::cout << "  checksums " << (c1 == c2 && c2 == c3 && c3 == c4 ? "match" : "DIFFER") << std::endl;
+    }
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. constexpr hashing:
+ *    - fnv1a is an ordinary loop, but marked constexpr, so `"start"_h` is evaluated by the compiler
+ *      and becomes an integer constant, which is exactly what a case label needs.
+ *    - A hash match only says "probably": the `cmd == "start"` check rejects other strings that
+ *      happen to share the hash.
+ *
+ * 2. Perfect hashing:
+ *    - One seed for all K keys works only if no two of them collide, a chance of roughly
+ *      exp(-K^2 / (2 * Slots)): fine for 16 keys, hopeless for 64. Giving each bucket of about two
+ *      keys its own seed turns that into many tiny searches of a few tries each (CHD,
+ *      hash-and-displace). The search runs during compilation; the program only contains the
+ *      finished table.
+ *    - A miss costs the same as a hit: one hash, one bucket seed, one slot, one comparison.
+ *
+ * 3. Why unordered_map is slower:
+ *    - It hashes with a general-purpose function, follows a pointer to a bucket node and compares
+ *      std::string keys stored in separate heap allocations.
+ *
+ * Tips and Tricks:
+ * - Keep the handler table next to the list of names so adding a command is a one-line change.
+ * - Hash the string once and reuse it when the same key is looked up in several tables.
+ */
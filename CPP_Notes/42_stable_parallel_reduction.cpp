@@ -0,0 +1,285 @@
+/**
+ * @file 42_stable_parallel_reduction.cpp
+ * @brief Demonstrates fast, accurate and bit-reproducible parallel summation of doubles.
+ *
+ * `add(2.5, 3.5)` in 16_functions.cpp adds one pair. Summing millions of doubles with
+ * `total = add(total, x)` has three problems:
+ *
+ * - **Accuracy**: once `total` is large, the low bits of each small `x` are rounded away, and the
+ *   error grows with the number of additions.
+ * - **Speed**: every addition waits for the previous one (about 4 cycles of latency), so the loop
+ *   runs at a fraction of what the floating-point units can do.
+ * - **Reproducibility**: floating-point addition is not associative, so splitting the work across
+ *   a different number of threads usually changes the last bits of the result.
+ *
+ * This program provides:
+ *
+ * - `pairwiseSum`: adds blocks, then adds the block sums as a tree (error grows with log n, not n),
+ * - `neumaierSum`: compensated summation that carries the rounding error of each addition in a
+ *   second variable (error nearly independent of n),
+ * - `compensatedSumLanes`: the same error term computed with Knuth's branch-free TwoSum in eight
+ *   independent lanes, so additions overlap and the compiler can vectorize,
+ * - `parallelSum`: splits the array into chunks of a FIXED size (not "one per thread"), lets threads
+ *   take chunks in any order, and combines the chunk results in chunk order. The result is bit
+ *   identical for 1, 2, 4 or any number of threads.
+ *
+ * The error is measured against the exact sum: the input values are multiples of 2^-32, so their
+ * exact sum fits in a 128-bit integer.
+ *
+ * @note Compile with `-std=c++17 -O3 -pthread` (GCC vectorizes the eight-lane loops only at -O3). Never use `-ffast-math` here: it allows the compiler to
+ * reorder additions and deletes the compensation terms as algebraically zero.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// From 16_functions.cpp.
+template <typename T>
+T add(T a, T b) {
+    return a + b;
+}
+
+// The naive loop: one running total.
+double naiveSum(const double* data, std::size_t n) {
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total = add(total, data[i]);
+    }
+    return total;
+}
+
+/**
+ * @brief A sum plus the accumulated rounding error of the additions that produced it.
+ */
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    // Neumaier's variant of Kahan summation: also correct when x is larger than sum.
+    void add(double x) {
+        double t = sum + x;
+        compensation += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+        sum = t;
+    }
+
+    void add(const CompensatedSum& other) {
+        add(other.sum);
+        compensation += other.compensation;
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+// Compensated summation, one lane.
+double neumaierSum(const double* data, std::size_t n) {
+    CompensatedSum acc;
+    for (std::size_t i = 0; i < n; ++i) {
+        acc.add(data[i]);
+    }
+    return acc.value();
+}
+
+// Compensated summation over eight interleaved lanes, combined in a fixed order.
+constexpr std::size_t Lanes = 8;
+
+CompensatedSum compensatedLanes(const double* data, std::size_t n) {
+    double sum[Lanes] = {};
+    double comp[Lanes] = {};
+    std::size_t i = 0;
+    for (; i + Lanes <= n; i += Lanes) {
+        for (std::size_t k = 0; k < Lanes; ++k) {
+            // Knuth's TwoSum: the same error term as Neumaier's, without the comparison,
+            // so the loop has no branch and vectorizes.
+            double x = data[i + k];
+            double t = sum[k] + x;
+            double z = t - sum[k];
+            comp[k] += (sum[k] - (t - z)) + (x - z);
+            sum[k] = t;
+        }
+    }
+    CompensatedSum total;
+    for (std::size_t k = 0; k < Lanes; ++k) {
+        total.add(CompensatedSum{sum[k], comp[k]});
+    }
+    for (; i < n; ++i) {
+        total.add(data[i]);
+    }
+    return total;
+}
+
+double compensatedSumLanes(const double* data, std::size_t n) {
+    return compensatedLanes(data, n).value();
+}
+
+// Pairwise summation: small blocks with eight accumulators, then a recursive halving tree.
+double pairwiseSum(const double* data, std::size_t n) {
+    constexpr std::size_t Block = 128;
+    if (n <= Block) {
+        double acc[Lanes] = {};
+        std::size_t i = 0;
+        for (; i + Lanes <= n; i += Lanes) {
+            for (std::size_t k = 0; k < Lanes; ++k) {
+                acc[k] += data[i + k];
+            }
+        }
+        double total = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+        for (; i < n; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+    std::size_t half = (n / 2 + Lanes - 1) / Lanes * Lanes; // Keep the left half a multiple of 8.
+    return pairwiseSum(data, half) + pairwiseSum(data + half, n - half);
+}
+
+/**
+ * @brief Deterministic parallel reduction.
+ *
+ * The array is cut into chunks of ChunkSize elements no matter how many threads run. Threads claim
+ * chunks with an atomic counter and store each chunk's result in its own slot; the slots are then
+ * combined from first to last on the calling thread. Every addition therefore happens in the same
+ * order for any thread count, so the result is bit-for-bit the same.
+ */
+constexpr std::size_t ChunkSize = std::size_t{1} << 16;
+
+template <typename ChunkKernel>
+double parallelSum(const double* data, std::size_t n, unsigned threads, ChunkKernel kernel) {
+    std::size_t chunks = (n + ChunkSize - 1) / ChunkSize;
+    std::vector<CompensatedSum> results(chunks);
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&] {
+        for (std::size_t c = next.fetch_add(1); c < chunks; c = next.fetch_add(1)) {
+            std::size_t begin = c * ChunkSize;
+            results[c] = kernel(data + begin, std::min(ChunkSize, n - begin));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    CompensatedSum total;
+    for (const CompensatedSum& r : results) {
+        total.add(r);
+    }
+    return total.value();
+}
+
+// Generate values k * 2^-32 over a wide range of magnitudes and return the exact sum, rounded once.
+double makeData(std::vector<double>& values, std::size_t n) {
+    std::mt19937_64 rng(2024);
+    values.resize(n);
+    __extension__ __int128 exact = 0; // GCC/Clang extension; __extension__ keeps -Wpedantic quiet.
+    for (std::size_t i = 0; i < n; ++i) {
+        // |k| < 2^53, so k * 2^-32 is an exact double; the shift spreads magnitudes over 12 decades.
+        std::int64_t k = static_cast<std::int64_t>(rng() >> 11) >> (rng() % 40);
+        k = (rng() & 1) ? k : -k;
+        if (i % 4 == 0) {
+            k = std::abs(k); // A slight positive bias makes the total large, like real data.
+        }
+        exact += k;
+        values[i] = std::ldexp(static_cast<double>(k), -32);
+    }
+    return std::ldexp(static_cast<double>(exact), -32);
+}
+
+// Distance between two doubles in units in the last place.
+double ulpsBetween(double a, double b) {
+    return std::fabs(a - b) / (std::nextafter(std::fabs(b), INFINITY) - std::fabs(b));
+}
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+int main() {
+    std::cout << "Template Add: " << add(2.5, 3.5) << std::endl;
+
+    const std::size_t n = std::size_t{1} << 24; // 16M doubles = 128 MB
+    std::vector<double> values;
+    double exact = makeData(values, n);
+    const double* data = values.data();
+    std::printf("\nExact sum (rounded once): %.17g\n\n", exact);
+
+    struct Method {
+        const char* name;
+        double (*sum)(const double*, std::size_t);
+    };
+    const Method methods[] = {
+        {"naive add() loop", naiveSum},
+        {"pairwise", pairwiseSum},
+        {"Neumaier, 1 lane", neumaierSum},
+        {"TwoSum, 8 lanes", compensatedSumLanes},
+    };
+    std::printf("%-22s %10s %10s %14s\n", "method", "ms", "GB/s", "error (ulps)");
+    for (const Method& m : methods) {
+        double result = 0;
+        double ms = bestOfMs(3, [&] { result = m.sum(data, n); });
+        std::printf("%-22s %10.2f %10.2f %14.1f\n", m.name, ms, n * sizeof(double) / ms / 1e6,
+                    ulpsBetween(result, exact));
+    }
+
+    // Parallel: same result for every thread count.
+    std::printf("\nParallel TwoSum, %zu-element chunks combined in order:\n", ChunkSize);
+    double first = 0;
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        double result = 0;
+        double ms = bestOfMs(3, [&] { result = parallelSum(data, n, threads, compensatedLanes); });
+        if (threads == 1) {
+            first = result;
+        }
+        std::printf("  %u thread(s): %8.2f ms  %8.2f GB/s  error %.1f ulps  bits %s\n", threads, ms,
+                    n * sizeof(double) / ms / 1e6, ulpsBetween(result, exact),
+                    std::memcmp(&result, &first, sizeof(double)) == 0 ? "identical" : "DIFFER");
+    }
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Compensated summation:
+ *    - For t = s + x, the expression (s - t) + x (when |s| >= |x|) recovers exactly the part of x
+ *      that was rounded away. Adding those pieces up separately and folding them in at the end gives
+ *      nearly the exactly rounded sum.
+ *    - TwoSum (z = t - s; error = (s - (t - z)) + (x - z)) gets the same error with two more
+ *      subtractions but no comparison, which is what SIMD units prefer.
+ *
+ * 2. Multiple accumulators:
+ *    - A single running sum is a chain of dependent additions. Eight lanes give the CPU eight
+ *      independent chains to overlap and let the compiler use SIMD registers. The lanes are combined
+ *      in a fixed order, so the result does not depend on timing.
+ *
+ * 3. Deterministic parallelism:
+ *    - The chunk size is a constant, so chunk k always covers the same elements and is always summed
+ *      the same way. Only WHICH thread computes it changes, and that does not affect the bits.
+ *
+ * Tips and Tricks:
+ * - Pairwise summation is almost free and already far better than the naive loop.
+ * - Use compensated sums when the result feeds a comparison or a checksum that must be reproducible.
+ */
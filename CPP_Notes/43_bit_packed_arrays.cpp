@@ -0,0 +1,393 @@
+/**
+ * @file 43_bit_packed_arrays.cpp
+ * @brief Demonstrates compressed integer arrays (frame of reference and delta bit-packing) with SIMD decoding.
+ *
+ * The array filled by std::iota in 13a_iota_raw_arrays.cpp and the small values in
+ * 26_pointer_array_arithmetic.cpp are stored as full 32-bit ints, although the values need far fewer
+ * bits. When a loop over such data is limited by memory bandwidth, storing fewer bits and decoding
+ * them in registers is faster than reading the raw ints.
+ *
+ * `PackedIntArray<Delta, BlockSize>` splits the input into blocks of 128 or 256 values and stores each
+ * block with only as many bits per value as that block needs:
+ *
+ * - **Frame of reference (FOR)**, `Delta = false`: each value is stored as `value - min(block)`.
+ *   Good for small-range data, such as values between 0 and 1000.
+ * - **Delta + FOR**, `Delta = true`: each value is stored as the difference from the value four
+ *   positions earlier, minus the smallest such difference in the block. Good for sorted data such as
+ *   iota sequences and ID lists, where the differences are tiny even when the values are huge.
+ *
+ * Values are laid out "vertically" across four 32-bit lanes (value i goes to lane i % 4), so one
+ * 128-bit SSE2 register decodes four values at a time with shifts, ORs and masks. For every bit width
+ * 0..32 there is a separate decoder whose shifts are compile-time constants, generated with
+ * std::integer_sequence and picked from a table. For deltas, "difference from four positions earlier"
+ * means the running sum is a plain vector add, with no shuffles.
+ *
+ * `get(i)` reads one FOR value in O(1). Delta blocks are decoded whole with `decodeBlock(b)`.
+ *
+ * The benchmark reports the compression ratio and decode+sum throughput against summing raw ints.
+ *
+ * @note Compile with `-std=c++17 -O3`, so the loops that consume decoded blocks are vectorized too.
+ * The SIMD path needs SSE2 (always present on x86-64); other targets use the scalar decoder.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bitpack {
+
+constexpr int Lanes = 4;
+
+constexpr std::uint32_t lowMask(int bits) {
+    return bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+constexpr int bitsNeeded(std::uint32_t value) {
+    int bits = 0;
+    while (bits < 32 && (value >> bits) != 0) {
+        ++bits;
+    }
+    return bits;
+}
+
+// Pack rows * 4 values of `bits` bits each. Lane k of row r starts at bit r * bits of lane k's stream,
+// and word w of lane k is out[w * 4 + k]. `out` must be zeroed and hold rows * bits / 8 words.
+void packBlock(const std::uint32_t* in, int rows, int bits, std::uint32_t* out) {
+    if (bits == 0) {
+        return;
+    }
+    for (int r = 0; r < rows; ++r) {
+        int bit = r * bits;
+        int word = bit >> 5;
+        int shift = bit & 31;
+        for (int lane = 0; lane < Lanes; ++lane) {
+            std::uint32_t v = in[r * Lanes + lane];
+            out[word * Lanes + lane] |= v << shift;
+            if (shift + bits > 32) {
+                out[(word + 1) * Lanes + lane] |= v >> (32 - shift);
+            }
+        }
+    }
+}
+
+// Portable decoder, also used for single-value access.
+std::uint32_t unpackOne(const std::uint32_t* in, int bits, int row, int lane) {
+    if (bits == 0) {
+        return 0;
+    }
+    int bit = row * bits;
+    int word = bit >> 5;
+    int shift = bit & 31;
+    std::uint32_t v = in[word * Lanes + lane] >> shift;
+    if (shift + bits > 32) {
+        v |= in[(word + 1) * Lanes + lane] << (32 - shift);
+    }
+    return v & lowMask(bits);
+}
+
+// Decode a whole block. For FOR: out = base + v. For delta: out = previous row + step + v.
+void unpackBlockScalar(const std::uint32_t* in, int rows, int bits, std::uint32_t base, std::uint32_t step,
+                       bool delta, std::uint32_t* out) {
+    std::uint32_t acc[Lanes] = {base, base, base, base};
+    for (int r = 0; r < rows; ++r) {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            std::uint32_t v = unpackOne(in, bits, r, lane);
+            if (delta) {
+                acc[lane] += step + v;
+                out[r * Lanes + lane] = acc[lane];
+            } else {
+                out[r * Lanes + lane] = base + v;
+            }
+        }
+    }
+}
+
+using UnpackFn = void (*)(const std::uint32_t* in, std::uint32_t base, std::uint32_t step, std::uint32_t* out);
+
+#if defined(__SSE2__)
+// One row of four values; every shift amount is a template constant.
+template <int Bits, bool Delta, int Row>
+inline void unpackRow(const __m128i* src, __m128i* dst, __m128i mask, __m128i step, __m128i& acc) {
+    constexpr int bit = Row * Bits;
+    constexpr int word = bit >> 5;
+    constexpr int shift = bit & 31;
+    __m128i v = _mm_setzero_si128();
+    if constexpr (Bits > 0) {
+        v = _mm_srli_epi32(_mm_loadu_si128(src + word), shift);
+        if constexpr (shift + Bits > 32) {
+            v = _mm_or_si128(v, _mm_slli_epi32(_mm_loadu_si128(src + word + 1), 32 - shift));
+        }
+        if constexpr (Bits < 32) {
+            v = _mm_and_si128(v, mask);
+        }
+    }
+    if constexpr (Delta) {
+        acc = _mm_add_epi32(acc, _mm_add_epi32(v, step)); // Running sum, one add per lane.
+        _mm_storeu_si128(dst + Row, acc);
+    } else {
+        _mm_storeu_si128(dst + Row, _mm_add_epi32(v, acc)); // acc holds the block minimum.
+    }
+}
+
+template <int Bits, bool Delta, int... Rows>
+void unpackRows(const __m128i* src, __m128i* dst, __m128i mask, __m128i step, __m128i acc,
+                std::integer_sequence<int, Rows...>) {
+    (unpackRow<Bits, Delta, Rows>(src, dst, mask, step, acc), ...);
+}
+
+template <int Bits, bool Delta, int RowCount>
+void unpackBlockSimd(const std::uint32_t* in, std::uint32_t base, std::uint32_t step, std::uint32_t* out) {
+    unpackRows<Bits, Delta>(reinterpret_cast<const __m128i*>(in), reinterpret_cast<__m128i*>(out),
+                            _mm_set1_epi32(static_cast<int>(lowMask(Bits))), _mm_set1_epi32(static_cast<int>(step)),
+                            _mm_set1_epi32(static_cast<int>(base)), std::make_integer_sequence<int, RowCount>{});
+}
+
+template <bool Delta, int RowCount, int... Bits>
+constexpr std::array<UnpackFn, 33> makeUnpackTable(std::integer_sequence<int, Bits...>) {
+    return {{&unpackBlockSimd<Bits, Delta, RowCount>...}};
+}
+#endif
+
+} // namespace bitpack
+
+/**
+ * @brief Read-only compressed array of ints, decoded block by block.
+ */
+template <bool Delta, int BlockSize = 128>
+class PackedIntArray {
+    static_assert(BlockSize % 128 == 0, "blocks hold a multiple of 128 values");
+    static constexpr int Rows = BlockSize / bitpack::Lanes;
+
+public:
+    PackedIntArray(const int* data, std::size_t n) : size_(n) {
+        std::uint32_t block[BlockSize];
+        std::uint32_t encoded[BlockSize];
+        for (std::size_t start = 0; start < n; start += BlockSize) {
+            std::size_t count = std::min<std::size_t>(BlockSize, n - start);
+            for (std::size_t i = 0; i < BlockSize; ++i) {
+                // Pad the last block with its final value, which keeps the bit width small.
+                block[i] = static_cast<std::uint32_t>(data[start + std::min(i, count - 1)]);
+            }
+            Header header = encode(block, encoded);
+            header.offset = static_cast<std::uint32_t>(words_.size());
+            words_.resize(words_.size() + static_cast<std::size_t>(Rows) * header.bits / 8);
+            bitpack::packBlock(encoded, Rows, header.bits, words_.data() + header.offset);
+            headers_.push_back(header);
+        }
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t blockCount() const { return headers_.size(); }
+    std::size_t compressedBytes() const {
+        return words_.size() * sizeof(std::uint32_t) + headers_.size() * sizeof(Header);
+    }
+
+    // Decode block b into out (room for BlockSize values); returns the number of real values.
+    std::size_t decodeBlock(std::size_t b, int* out) const {
+        const Header& h = headers_[b];
+        auto* dst = reinterpret_cast<std::uint32_t*>(out);
+#if defined(__SSE2__)
+        static constexpr auto table = bitpack::makeUnpackTable<Delta, Rows>(std::make_integer_sequence<int, 33>{});
+        table[h.bits](words_.data() + h.offset, h.base, h.step, dst);
+#else
+        bitpack::unpackBlockScalar(words_.data() + h.offset, Rows, h.bits, h.base, h.step, Delta, dst);
+#endif
+        return std::min<std::size_t>(BlockSize, size_ - b * BlockSize);
+    }
+
+    // Random access. O(1) for FOR; delta blocks must be decoded up to the value.
+    int get(std::size_t i) const {
+        std::size_t b = i / BlockSize;
+        int index = static_cast<int>(i % BlockSize);
+        const Header& h = headers_[b];
+        if constexpr (!Delta) {
+            return static_cast<int>(h.base + bitpack::unpackOne(words_.data() + h.offset, h.bits,
+                                                                index / bitpack::Lanes, index % bitpack::Lanes));
+        } else {
+            int block[BlockSize];
+            decodeBlock(b, block);
+            return block[index];
+        }
+    }
+
+    // Call fn(values, count) for every block in order.
+    template <typename Fn>
+    void forEachBlock(Fn&& fn) const {
+        alignas(16) int block[BlockSize];
+        for (std::size_t b = 0; b < headers_.size(); ++b) {
+            std::size_t count = decodeBlock(b, block);
+            fn(static_cast<const int*>(block), count);
+        }
+    }
+
+private:
+    struct Header {
+        std::uint32_t base;   // FOR: block minimum. Delta: first value.
+        std::uint32_t step;   // Delta: smallest difference in the block.
+        std::uint32_t offset; // Index of the block's first word.
+        std::uint32_t bits;   // Bits per packed value, 0..32.
+    };
+
+    // Turn one block into small non-negative numbers and pick the bit width.
+    static Header encode(const std::uint32_t* block, std::uint32_t* out) {
+        Header header{};
+        if constexpr (!Delta) {
+            // Compare as signed ints, store the unsigned distance from the minimum.
+            int minValue = static_cast<int>(block[0]);
+            for (int i = 1; i < BlockSize; ++i) {
+                minValue = std::min(minValue, static_cast<int>(block[i]));
+            }
+            header.base = static_cast<std::uint32_t>(minValue);
+            for (int i = 0; i < BlockSize; ++i) {
+                out[i] = block[i] - header.base;
+            }
+        } else {
+            // Differences from four values earlier; the first row is relative to block[0].
+            header.base = block[0];
+            std::uint32_t minStep = 0xFFFFFFFFu;
+            for (int i = 0; i < BlockSize; ++i) {
+                out[i] = block[i] - (i < bitpack::Lanes ? header.base : block[i - bitpack::Lanes]);
+                minStep = std::min(minStep, out[i]);
+            }
+            header.step = minStep;
+            for (int i = 0; i < BlockSize; ++i) {
+                out[i] -= minStep;
+            }
+        }
+        std::uint32_t orAll = 0;
+        for (int i = 0; i < BlockSize; ++i) {
+            orAll |= out[i];
+        }
+        header.bits = static_cast<std::uint32_t>(bitpack::bitsNeeded(orAll));
+        return header;
+    }
+
+    std::size_t size_;
+    std::vector<Header> headers_;
+    std::vector<std::uint32_t> words_;
+};
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+// Decode everything and compare with the input.
+template <typename Packed>
+bool verify(const Packed& packed, const std::vector<int>& original) {
+    std::size_t position = 0;
+    bool ok = true;
+    packed.forEachBlock([&](const int* values, std::size_t count) {
+        ok = ok && std::equal(values, values + count, original.begin() + position);
+        position += count;
+    });
+    return ok && position == original.size() && packed.get(original.size() / 2) == original[original.size() / 2];
+}
+
+template <typename Packed>
+void benchmarkPacked(const char* name, const std::vector<int>& values, double rawMs) {
+    Packed packed(values.data(), values.size());
+    long long sum = 0;
+    double ms = bestOfMs(5, [&] {
+        long long total = 0;
+        packed.forEachBlock([&](const int* block, std::size_t count) {
+            long long blockSum = 0; // A local, so the compiler keeps it in a register.
+            for (std::size_t i = 0; i < count; ++i) {
+                blockSum += block[i];
+            }
+            total += blockSum;
+        });
+        sum = total;
+    });
+    double rawBytes = static_cast<double>(values.size() * sizeof(int));
+    std::printf("  %-16s ratio %5.2fx  %7.2f ms  %6.2f GB/s  (raw %.2fx)  sum %lld  %s\n", name,
+                rawBytes / packed.compressedBytes(), ms, rawBytes / ms / 1e6, rawMs / ms, sum,
+                verify(packed, values) ? "verified" : "MISMATCH");
+}
+
+void benchmarkDataset(const char* title, const std::vector<int>& values) {
+    long long rawSum = 0;
+    double rawMs = bestOfMs(5, [&] { rawSum = std::accumulate(values.begin(), values.end(), 0LL); });
+    std::printf("\n%s\n  %-16s ratio  1.00x  %7.2f ms  %6.2f GB/s               sum %lld\n", title, "raw int[]",
+                rawMs, values.size() * sizeof(int) / rawMs / 1e6, rawSum);
+    benchmarkPacked<PackedIntArray<false, 128>>("FOR, 128", values, rawMs);
+    benchmarkPacked<PackedIntArray<false, 256>>("FOR, 256", values, rawMs);
+    benchmarkPacked<PackedIntArray<true, 128>>("delta, 128", values, rawMs);
+    benchmarkPacked<PackedIntArray<true, 256>>("delta, 256", values, rawMs);
+}
+
+int main() {
+    // 13a_iota_raw_arrays.cpp: int arr[10] filled with std::iota.
+    int arr[10];
+    std::iota(std::begin(arr), std::end(arr), 0);
+    PackedIntArray<true> small(arr, 10);
+    std::cout << "Array contents (decoded): ";
+    for (std::size_t i = 0; i < small.size(); ++i) {
+        std::cout << small.get(i) << " ";
+    }
+    std::cout << std::endl;
+
+    const std::size_t n = std::size_t{1} << 24; // 16M ints = 64 MB raw
+    std::mt19937 rng(5);
+
+    std::vector<int> iota(n);
+    std::iota(iota.begin(), iota.end(), 0);
+    benchmarkDataset("std::iota 0..n-1 (13a_iota_raw_arrays.cpp):", iota);
+
+    std::vector<int> ids(n);
+    int id = 1000000;
+    for (int& v : ids) {
+        id += static_cast<int>(rng() % 64);
+        v = id;
+    }
+    benchmarkDataset("Sorted IDs with gaps of 0..63:", ids);
+
+    std::vector<int> smallRange(n);
+    for (int& v : smallRange) {
+        v = 10 + static_cast<int>(rng() % 1000);
+    }
+    benchmarkDataset("Random values in [10, 1010) (26_pointer_array_arithmetic.cpp-style):", smallRange);
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Frame of reference:
+ *    - A block whose values lie in [min, min + 2^b) only needs b bits per value once min is
+ *      subtracted. Each block picks its own b, so a few outliers only hurt their own block.
+ *
+ * 2. Delta coding:
+ *    - Sorted data has small differences between neighbours. Using the difference from the value
+ *      four positions back (one per lane) keeps decoding a vertical running sum: one SIMD add per
+ *      four values.
+ *
+ * 3. Vertical layout and generated decoders:
+ *    - Because lane k only holds values k, k+4, k+8, ..., the same shift applies to all four lanes
+ *      of a row, so one SSE2 instruction handles four values. The 33 decoders (one per bit width)
+ *      are generated from one template, and their shifts are immediate constants.
+ *
+ * Tips and Tricks:
+ * - Decode into a small stack buffer and process it while it is in L1, as forEachBlock does.
+ * - Keep random access coarse: find the block first, then decode or scan inside it.
+ */
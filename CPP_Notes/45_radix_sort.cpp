@@ -0,0 +1,301 @@
+/**
+ * @file 45_radix_sort.cpp
+ * @brief Demonstrates LSD radix sort for integer keys: 8/11-bit digits, digit skipping, threads and argsort.
+ *
+ * The array lessons (13_raw_arrays.cpp, 13a_iota_raw_arrays.cpp) never sort. std::sort is a
+ * comparison sort: O(n log n) comparisons with unpredictable branches. For plain integer keys,
+ * least-significant-digit (LSD) radix sort does a fixed number of linear passes instead:
+ *
+ * - split each key into digits (8 bits: 4 passes for 32-bit keys; 11 bits: 3 passes),
+ * - for each digit, from least to most significant, count how many keys have each digit value and
+ *   scatter the keys into a second buffer in that order. Each pass is stable, so after the last
+ *   pass the keys are fully sorted.
+ *
+ * Additions in this lesson:
+ *
+ * - **Digit skipping**: all histograms are built in one read of the input. A digit that is the same
+ *   for every key (for example the high bytes of small values) puts all n keys in one bucket, and
+ *   its pass is skipped.
+ * - **Signed keys**: flipping the sign bit makes two's-complement ints sort correctly as unsigned.
+ * - **Key-value sorting and argsort**: values move together with their keys, so sorting
+ *   (key, index) pairs gives the stable sorting permutation.
+ * - **Parallel sort**: each thread counts its slice; prefix sums over (digit, thread) give every
+ *   thread its own output ranges, so the scatter is parallel and still stable.
+ *
+ * The benchmark compares std::sort, 8- and 11-bit radix sort and the parallel version on uniform,
+ * skewed and presorted inputs, plus argsort against std::stable_sort of indices.
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Marker type for "keys only".
+struct NoValues {};
+
+// Map a key to unsigned bits that sort in the same order.
+template <typename Key>
+inline std::make_unsigned_t<Key> sortBits(Key key) {
+    using U = std::make_unsigned_t<Key>;
+    U bits = static_cast<U>(key);
+    if constexpr (std::is_signed_v<Key>) {
+        bits ^= U(1) << (sizeof(U) * 8 - 1); // Negative numbers first.
+    }
+    return bits;
+}
+
+// Run fn(t) on `threads` threads (the calling thread is thread 0) and wait for all of them.
+template <typename Fn>
+void runOnThreads(unsigned threads, Fn&& fn) {
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief LSD radix sort of keys[0, n), optionally carrying values[] along.
+ *
+ * Uses a temporary buffer of n keys (and n values). threads == 1 runs the serial algorithm.
+ */
+template <int DigitBits, typename Key, typename Value = NoValues>
+void radixSort(Key* keys, std::size_t n, Value* values = nullptr, unsigned threads = 1) {
+    static_assert(std::is_integral_v<Key>, "radix sort needs integer keys");
+    constexpr bool HasValues = !std::is_same_v<Value, NoValues>;
+    constexpr int KeyBits = static_cast<int>(sizeof(Key) * 8);
+    constexpr int Passes = (KeyBits + DigitBits - 1) / DigitBits;
+    constexpr std::size_t Buckets = std::size_t{1} << DigitBits;
+    constexpr auto Mask = static_cast<std::make_unsigned_t<Key>>(Buckets - 1);
+    if (n < 2) {
+        return;
+    }
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(n / 65536 + 1)));
+
+    // One read of the input builds the histograms of every digit (per thread, then summed).
+    std::vector<std::array<std::size_t, Buckets>> counts(static_cast<std::size_t>(Passes) * threads);
+    auto slice = [&](unsigned t) {
+        return std::make_pair(n * t / threads, n * (t + 1) / threads);
+    };
+    runOnThreads(threads, [&](unsigned t) {
+        auto [begin, end] = slice(t);
+        auto* local = &counts[static_cast<std::size_t>(t) * Passes];
+        for (int p = 0; p < Passes; ++p) {
+            local[p].fill(0);
+        }
+        for (std::size_t i = begin; i < end; ++i) {
+            auto bits = sortBits(keys[i]);
+            for (int p = 0; p < Passes; ++p) {
+                ++local[p][(bits >> (p * DigitBits)) & Mask];
+            }
+        }
+    });
+
+    std::vector<Key> keyBuffer(n);
+    std::vector<std::conditional_t<HasValues, Value, char>> valueBuffer(HasValues ? n : 0);
+    Key* srcKeys = keys;
+    Key* dstKeys = keyBuffer.data();
+    Value* srcValues = values;
+    [[maybe_unused]] Value* dstValues = nullptr;
+    if constexpr (HasValues) {
+        dstValues = valueBuffer.data();
+    }
+
+    std::vector<std::array<std::size_t, Buckets>> offsets(threads);
+    for (int p = 0; p < Passes; ++p) {
+        // Skip the pass if every key has the same digit: the scatter would not move anything.
+        bool constant = false;
+        for (std::size_t d = 0; d < Buckets && !constant; ++d) {
+            std::size_t total = 0;
+            for (unsigned t = 0; t < threads; ++t) {
+                total += counts[static_cast<std::size_t>(t) * Passes + p][d];
+            }
+            constant = total == n;
+        }
+        if (constant) {
+            continue;
+        }
+
+        // Per-pass counts per thread. The first pass can reuse the counts from the initial read;
+        // later passes must recount because keys have moved between slices.
+        if (p > 0 && threads > 1) {
+            runOnThreads(threads, [&](unsigned t) {
+                auto [begin, end] = slice(t);
+                auto& local = counts[static_cast<std::size_t>(t) * Passes + p];
+                local.fill(0);
+                for (std::size_t i = begin; i < end; ++i) {
+                    ++local[(sortBits(srcKeys[i]) >> (p * DigitBits)) & Mask];
+                }
+            });
+        }
+
+        // Exclusive prefix sum over (digit, thread): thread t writes digit d after threads < t.
+        std::size_t running = 0;
+        for (std::size_t d = 0; d < Buckets; ++d) {
+            for (unsigned t = 0; t < threads; ++t) {
+                offsets[t][d] = running;
+                running += counts[static_cast<std::size_t>(t) * Passes + p][d];
+            }
+        }
+
+        runOnThreads(threads, [&](unsigned t) {
+            auto [begin, end] = slice(t);
+            auto& next = offsets[t];
+            for (std::size_t i = begin; i < end; ++i) {
+                std::size_t slot = next[(sortBits(srcKeys[i]) >> (p * DigitBits)) & Mask]++;
+                dstKeys[slot] = srcKeys[i];
+                if constexpr (HasValues) {
+                    dstValues[slot] = srcValues[i];
+                }
+            }
+        });
+        std::swap(srcKeys, dstKeys);
+        if constexpr (HasValues) {
+            std::swap(srcValues, dstValues);
+        }
+    }
+
+    // After an odd number of executed passes the result is in the temporary buffer.
+    if (srcKeys != keys) {
+        std::copy(srcKeys, srcKeys + n, keys);
+        if constexpr (HasValues) {
+            std::copy(srcValues, srcValues + n, values);
+        }
+    }
+}
+
+// Stable sorting permutation: keys[result[0]] <= keys[result[1]] <= ...
+template <int DigitBits = 11, typename Key>
+std::vector<std::uint32_t> argsort(const Key* keys, std::size_t n, unsigned threads = 1) {
+    std::vector<Key> copy(keys, keys + n);
+    std::vector<std::uint32_t> index(n);
+    std::iota(index.begin(), index.end(), 0u);
+    radixSort<DigitBits>(copy.data(), n, index.data(), threads);
+    return index;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Sort a fresh copy of input with each method; check every result against std::sort.
+template <typename Key>
+void benchmark(const char* title, const std::vector<Key>& input, unsigned threads) {
+    std::vector<Key> expected = input;
+    double stdMs = timeMs([&] { std::sort(expected.begin(), expected.end()); });
+    std::printf("%s\n  %-26s %8.1f ms\n", title, "std::sort", stdMs);
+
+    auto run = [&](const char* name, auto sorter) {
+        std::vector<Key> data = input;
+        double ms = timeMs([&] { sorter(data); });
+        std::printf("  %-26s %8.1f ms  %5.2fx  %s\n", name, ms, stdMs / ms, data == expected ? "ok" : "WRONG");
+    };
+    run("radix, 8-bit digits", [](std::vector<Key>& d) { radixSort<8>(d.data(), d.size()); });
+    run("radix, 11-bit digits", [](std::vector<Key>& d) { radixSort<11>(d.data(), d.size()); });
+    char name[64];
+    std::snprintf(name, sizeof(name), "radix, 11-bit, %u threads", threads);
+    run(name, [threads](std::vector<Key>& d) { radixSort<11>(d.data(), d.size(), static_cast<NoValues*>(nullptr), threads); });
+}
+
+int main() {
+    // Small example with negative numbers.
+    int arr[] = {42, -7, 13, 0, -128, 99, 13, 5};
+    radixSort<8>(arr, std::size(arr));
+    std::printf("Sorted: ");
+    for (int value : arr) {
+        std::printf("%d ", value);
+    }
+    std::printf("\n\n");
+
+    const std::size_t n = std::size_t{1} << 23; // 8M keys
+    const unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    std::mt19937_64 rng(11);
+
+    std::vector<std::uint32_t> uniform(n);
+    for (auto& key : uniform) {
+        key = static_cast<std::uint32_t>(rng());
+    }
+    benchmark("Uniform 32-bit keys (8M):", uniform, threads);
+
+    // Skewed: most keys are small (exponential-like), so the high digits are often constant.
+    std::vector<std::uint32_t> skewed(n);
+    std::exponential_distribution<double> exponential(1.0 / 5000.0);
+    for (auto& key : skewed) {
+        key = static_cast<std::uint32_t>(std::min(exponential(rng), 1e6));
+    }
+    benchmark("\nSkewed keys, all < 2^20 (8M):", skewed, threads);
+
+    std::vector<std::uint32_t> presorted(n);
+    std::iota(presorted.begin(), presorted.end(), 0u);
+    benchmark("\nPresorted keys 0..n-1 (8M):", presorted, threads);
+
+    std::vector<std::int64_t> wide(n / 2);
+    for (auto& key : wide) {
+        key = static_cast<std::int64_t>(rng());
+    }
+    benchmark("\nUniform signed 64-bit keys (4M):", wide, threads);
+
+    // Argsort: stable permutation, compared with std::stable_sort of indices.
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    double stableMs = timeMs([&] {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return skewed[a] < skewed[b]; });
+    });
+    std::vector<std::uint32_t> radixOrder;
+    double argsortMs = timeMs([&] { radixOrder = argsort(skewed.data(), n); });
+    std::printf("\nArgsort of the skewed keys:\n  %-26s %8.1f ms\n  %-26s %8.1f ms  %5.2fx  %s\n",
+                "std::stable_sort(indices)", stableMs, "radix argsort", argsortMs, stableMs / argsortMs,
+                radixOrder == order ? "ok" : "WRONG");
+    std::printf("\nHardware threads: %u\n", std::thread::hardware_concurrency());
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Counting and scattering:
+ *    - After counting, an exclusive prefix sum turns the counts into the first output position of
+ *      each digit value. Walking the input in order and writing each key to its digit's next slot
+ *      keeps equal digits in input order, which is what makes LSD radix sort correct.
+ *
+ * 2. Digit size:
+ *    - 8-bit digits need 4 passes over 32-bit keys with 256 counters; 11-bit digits need 3 passes
+ *      with 2048 counters. Fewer passes mean less memory traffic, as long as the counters and the
+ *      2048 active output streams still fit comfortably in the L1/L2 caches.
+ *
+ * 3. Parallel scatter:
+ *    - Ordering the prefix sum by (digit, thread) gives thread 0's keys of digit d the first slots
+ *      of that digit, thread 1's the next ones, and so on, so the parallel result is identical to
+ *      the serial one.
+ *
+ * 4. Where radix sort loses:
+ *    - Radix sort does the same passes whatever the input order, while std::sort is very fast on
+ *      presorted data. Presorted keys are even slower for radix sort than random ones: every bucket
+ *      holds exactly n / 256 (or n / 2048) keys, so the write positions are a power of two apart
+ *      and map to the same cache sets, evicting each other.
+ *    - With one hardware thread the parallel version can only add overhead; it needs real cores.
+ *
+ * Tips and Tricks:
+ * - Radix sort wins on large arrays of plain integers; for small arrays or complex comparisons use
+ *   std::sort.
+ * - Floating-point keys can be radix sorted too after mapping their bits to an order-preserving
+ *   unsigned integer.
+ */
@@ -0,0 +1,317 @@
+/**
+ * @file 46_parallel_scan.cpp
+ * @brief Demonstrates SIMD and multi-threaded prefix sums: inclusive, exclusive and segmented scans.
+ *
+ * std::iota in 13a_iota_raw_arrays.cpp fills an array with 0, 1, 2, ...: that is the exclusive
+ * prefix sum (scan) of an array of ones. Scans turn counts into offsets (as in the radix sort of
+ * 45_radix_sort.cpp), compact filtered data and build CSR graphs. A scan looks inherently serial:
+ * out[i] = out[i - 1] + in[i]. This program makes it fast in two steps:
+ *
+ * - **In-register SIMD scan**: four 32-bit lanes are scanned with two shifted adds
+ *   (x += x << 1 lane; x += x << 2 lanes), then the running total of the previous vectors is
+ *   added. The only serial dependency left is one add per four elements.
+ * - **Reduce-then-scan across threads**: each thread sums its slice (pass 1), the slice totals are
+ *   scanned serially (a handful of values), and each thread scans its slice again starting from its
+ *   carry-in (pass 2). The input is read twice, but both passes run in parallel.
+ *
+ * Variants: inclusive (out[i] includes in[i]), exclusive (out[i] is the sum before in[i]) and
+ * segmented (the sum restarts at every element whose head flag is set).
+ *
+ * The benchmark compares a plain loop, std::inclusive_scan, std::inclusive_scan with
+ * std::execution::par, the SIMD scans and the parallel scans with 2 and 4 threads.
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread -ltbb` (libstdc++ implements std::execution::par with
+ * Intel TBB). The SIMD code uses SSE2, which every x86-64 CPU has; other targets use the scalar loop.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <execution>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace scan {
+
+// Sums wrap modulo 2^32, like any unsigned offset counter.
+using Value = std::uint32_t;
+
+// Sum of in[0, n).
+inline Value reduce(const Value* in, std::size_t n) {
+    Value total = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total += in[i];
+    }
+    return total;
+}
+
+// Sum of the last segment of in[0, n): the elements from the last head flag on (all if none).
+inline Value reduceSegment(const Value* in, const std::uint8_t* heads, std::size_t n, bool& sawHead) {
+    std::size_t afterHead = n;
+    while (afterHead > 0 && heads[afterHead - 1] == 0) {
+        --afterHead;
+    }
+    sawHead = afterHead > 0;
+    std::size_t begin = sawHead ? afterHead - 1 : 0;
+    return reduce(in + begin, n - begin);
+}
+
+// Inclusive scan of in[0, n) into out, starting from carry. Returns carry + sum of the input.
+template <bool Exclusive = false>
+Value scanBlock(const Value* in, Value* out, std::size_t n, Value carry) {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    __m128i running = _mm_set1_epi32(static_cast<int>(carry));
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i sum = _mm_add_epi32(x, _mm_slli_si128(x, 4)); // [a, a+b, b+c, c+d]
+        sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 8));     // [a, a+b, a+b+c, a+b+c+d]
+        sum = _mm_add_epi32(sum, running);
+        __m128i result = Exclusive ? _mm_sub_epi32(sum, x) : sum;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+        running = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 3, 3, 3)); // Broadcast the last lane.
+    }
+    carry = static_cast<Value>(_mm_cvtsi128_si32(running));
+#endif
+    for (; i < n; ++i) {
+        Value x = in[i];
+        carry += x;
+        out[i] = Exclusive ? carry - x : carry;
+    }
+    return carry;
+}
+
+// Segmented inclusive scan: the running sum restarts at every i with heads[i] != 0.
+inline Value segmentedScanBlock(const Value* in, const std::uint8_t* heads, Value* out, std::size_t n, Value carry) {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    __m128i running = _mm_set1_epi32(static_cast<int>(carry));
+    for (; i + 4 <= n; i += 4) {
+        std::uint32_t flagBytes;
+        std::memcpy(&flagBytes, heads + i, 4);
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Widen the four flag bytes to all-ones / all-zeros lanes.
+        __m128i f = _mm_cvtsi32_si128(static_cast<int>(flagBytes));
+        f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(f, f), _mm_unpacklo_epi8(f, f));
+        f = _mm_cmpeq_epi32(_mm_cmpeq_epi32(f, _mm_setzero_si128()), _mm_setzero_si128());
+        // Combine (value, flag) pairs: a lane only adds its left neighbour if it has no head.
+        x = _mm_add_epi32(x, _mm_andnot_si128(f, _mm_slli_si128(x, 4)));
+        f = _mm_or_si128(f, _mm_slli_si128(f, 4));
+        x = _mm_add_epi32(x, _mm_andnot_si128(f, _mm_slli_si128(x, 8)));
+        f = _mm_or_si128(f, _mm_slli_si128(f, 8));
+        x = _mm_add_epi32(x, _mm_andnot_si128(f, running)); // Carry only reaches lanes before a head.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+        running = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = static_cast<Value>(_mm_cvtsi128_si32(running));
+#endif
+    for (; i < n; ++i) {
+        carry = heads[i] ? in[i] : carry + in[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+// Run fn(t) on `threads` threads (the calling thread is thread 0), as in 45_radix_sort.cpp.
+template <typename Fn>
+void runOnThreads(unsigned threads, Fn&& fn) {
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Reduce-then-scan over `threads` contiguous slices.
+ *
+ * Small inputs do not pay for thread start-up; they fall back to the single-threaded SIMD scan.
+ */
+template <bool Exclusive = false>
+void parallelScan(const Value* in, Value* out, std::size_t n, unsigned threads) {
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(n / 65536 + 1)));
+    if (threads == 1) {
+        scanBlock<Exclusive>(in, out, n, 0);
+        return;
+    }
+    std::vector<Value> carries(threads);
+    auto slice = [&](unsigned t) { return std::make_pair(n * t / threads, n * (t + 1) / threads); };
+
+    runOnThreads(threads, [&](unsigned t) {
+        auto [begin, end] = slice(t);
+        carries[t] = reduce(in + begin, end - begin);
+    });
+    Value running = 0;
+    for (Value& carry : carries) {
+        Value total = carry;
+        carry = running;
+        running += total;
+    }
+    runOnThreads(threads, [&](unsigned t) {
+        auto [begin, end] = slice(t);
+        scanBlock<Exclusive>(in + begin, out + begin, end - begin, carries[t]);
+    });
+}
+
+// Segmented version: a slice's carry-in stops at the first head before it.
+inline void parallelSegmentedScan(const Value* in, const std::uint8_t* heads, Value* out, std::size_t n,
+                                  unsigned threads) {
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(n / 65536 + 1)));
+    std::vector<Value> carries(threads);
+    std::vector<char> sawHead(threads);
+    auto slice = [&](unsigned t) { return std::make_pair(n * t / threads, n * (t + 1) / threads); };
+
+    if (threads > 1) {
+        runOnThreads(threads, [&](unsigned t) {
+            auto [begin, end] = slice(t);
+            bool head = false;
+            carries[t] = reduceSegment(in + begin, heads + begin, end - begin, head);
+            sawHead[t] = head;
+        });
+    }
+    Value running = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        Value total = carries[t];
+        carries[t] = running;
+        running = sawHead[t] ? total : running + total;
+    }
+    runOnThreads(threads, [&](unsigned t) {
+        auto [begin, end] = slice(t);
+        segmentedScanBlock(in + begin, heads + begin, out + begin, end - begin, carries[t]);
+    });
+}
+
+} // namespace scan
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+int main() {
+    using scan::Value;
+
+    // A scan of ones is std::iota: exclusive gives 0, 1, 2, ...
+    Value ones[10];
+    Value iota[10];
+    std::fill(std::begin(ones), std::end(ones), 1u);
+    scan::scanBlock<true>(ones, iota, 10, 0);
+    std::printf("Exclusive scan of ones: ");
+    for (Value value : iota) {
+        std::printf("%u ", value);
+    }
+    std::printf("\n\n");
+
+    const std::size_t n = std::size_t{1} << 25; // 32M values = 128 MB in, 128 MB out
+    std::vector<Value> in(n);
+    std::vector<std::uint8_t> heads(n);
+    std::mt19937 rng(5);
+    for (std::size_t i = 0; i < n; ++i) {
+        in[i] = rng() % 16;
+        heads[i] = rng() % 1000 == 0; // Segments of about 1000 elements.
+    }
+    heads[0] = 1;
+
+    // References from the plain serial loops.
+    std::vector<Value> inclusive(n), exclusive(n), segmented(n), out(n);
+    Value carry = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        exclusive[i] = carry;
+        carry += in[i];
+        inclusive[i] = carry;
+        segmented[i] = heads[i] ? in[i] : segmented[i - 1] + in[i];
+    }
+
+    auto report = [&](const char* name, const std::vector<Value>& expected, auto&& run) {
+        std::fill(out.begin(), out.end(), 0u);
+        double ms = bestOfMs(3, run);
+        std::printf("  %-36s %8.2f ms %7.2f GB/s  %s\n", name, ms, 2.0 * n * sizeof(Value) / ms / 1e6,
+                    out == expected ? "ok" : "WRONG");
+    };
+
+    std::printf("Inclusive scan of %zu values:\n", n);
+    report("plain loop", inclusive, [&] {
+        Value sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += in[i];
+            out[i] = sum;
+        }
+    });
+    report("std::inclusive_scan", inclusive, [&] { std::inclusive_scan(in.begin(), in.end(), out.begin()); });
+    report("std::inclusive_scan(par)", inclusive,
+           [&] { std::inclusive_scan(std::execution::par, in.begin(), in.end(), out.begin()); });
+    report("SIMD scan", inclusive, [&] { scan::scanBlock(in.data(), out.data(), n, 0); });
+    for (unsigned threads : {2u, 4u}) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "SIMD reduce-then-scan, %u threads", threads);
+        report(name, inclusive, [&] { scan::parallelScan(in.data(), out.data(), n, threads); });
+    }
+
+    std::printf("\nExclusive scan:\n");
+    report("std::exclusive_scan", exclusive, [&] { std::exclusive_scan(in.begin(), in.end(), out.begin(), 0u); });
+    report("SIMD scan", exclusive, [&] { scan::scanBlock<true>(in.data(), out.data(), n, 0); });
+    report("SIMD reduce-then-scan, 4 threads", exclusive,
+           [&] { scan::parallelScan<true>(in.data(), out.data(), n, 4); });
+
+    std::printf("\nSegmented scan (about 1000 elements per segment):\n");
+    report("plain loop", segmented, [&] {
+        Value sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum = heads[i] ? in[i] : sum + in[i];
+            out[i] = sum;
+        }
+    });
+    report("SIMD scan", segmented, [&] { scan::segmentedScanBlock(in.data(), heads.data(), out.data(), n, 0); });
+    report("SIMD reduce-then-scan, 4 threads", segmented,
+           [&] { scan::parallelSegmentedScan(in.data(), heads.data(), out.data(), n, 4); });
+
+    std::printf("\nHardware threads: %u\n", std::thread::hardware_concurrency());
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. In-register scan:
+ *    - Shifting a vector left by one lane and adding gives pairwise sums; shifting the result by two
+ *      lanes and adding gives the full prefix of four lanes (log2(4) = 2 steps). Broadcasting the
+ *      last lane gives the carry for the next vector.
+ *    - An exclusive scan is the inclusive scan minus the input, which costs one more subtraction.
+ *
+ * 2. Segmented scan:
+ *    - Each element is a (value, head flag) pair. Combining a left pair with a right pair gives the
+ *      right value if the right pair has a head, otherwise the sum, and the OR of the flags. This
+ *      operator is associative, so the same SIMD steps and the same reduce-then-scan work.
+ *    - Pass 1 only needs the sum after the slice's last head, so it reads the slice backwards up to
+ *      that head. With short segments pass 1 is almost free.
+ *
+ * 3. Reduce-then-scan:
+ *    - Pass 1 only reads; pass 2 reads and writes. Total traffic is 3n values instead of 2n, so it
+ *      pays off when there are enough cores to saturate memory bandwidth. On one core it is slower
+ *      than the serial scan.
+ *
+ * Tips and Tricks:
+ * - A scan is memory-bound once the data is larger than the caches; fuse it with the pass that
+ *   produces or consumes the data whenever possible.
+ * - Scanning chunks that fit in L2 (reduce a chunk, then scan it while it is still cached) reduces
+ *   the extra read of pass 1.
+ */
@@ -0,0 +1,309 @@
+/**
+ * @file 47_copy_on_write_buffer.cpp
+ * @brief Demonstrates a copy-on-write buffer that makes passing large payloads by value cheap.
+ *
+ * 21_pass_by_value_reference.cpp notes that pass by value "can be inefficient for large objects due
+ * to copying overhead". Pass by const reference avoids the copy, but it cannot be used when the
+ * callee keeps the object (a queue, another thread, a cache) beyond the caller's lifetime.
+ *
+ * `cow_buffer<T, RefCount>` keeps value semantics and removes the copy:
+ *
+ * - the elements live in one heap block together with a reference count and the size,
+ * - copying a buffer only copies a pointer and increments the count,
+ * - reading never copies; the first WRITE through a shared buffer (`mutable_data()`, `set()`)
+ *   detaches: it makes a private copy and releases its reference to the shared block,
+ * - writing to a buffer that is not shared modifies it in place.
+ *
+ * The reference count is a policy. `AtomicRefCount` (the default) lets copies be handed to other
+ * threads. `LocalRefCount` is a plain integer for buffers that never leave one thread, which
+ * saves the locked read-modify-write instruction on every copy and destruction.
+ *
+ * The benchmark passes payloads by value through a binary call tree and compares a deep-copying
+ * std::vector, std::shared_ptr<const std::vector> and both cow_buffer variants, for read-only
+ * callees, for leaves that write, and for tiny payloads where only the reference counting is left.
+ *
+ * @note Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Thread-safe reference count.
+ *
+ * Increments can be relaxed: a new reference is always made from an existing one. The decrement
+ * that reaches zero must see every write made through the other references before the block is
+ * destroyed, hence acq_rel.
+ */
+class AtomicRefCount {
+public:
+    void acquire() { count_.fetch_add(1, std::memory_order_relaxed); }
+    bool release() { return count_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    std::size_t count() const { return count_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<std::size_t> count_{1};
+};
+
+/**
+ * @brief Reference count for buffers that are only copied and destroyed on one thread.
+ */
+class LocalRefCount {
+public:
+    void acquire() { ++count_; }
+    bool release() { return --count_ == 0; }
+    std::size_t count() const { return count_; }
+
+private:
+    std::size_t count_ = 1;
+};
+
+/**
+ * @brief Immutable-by-default array whose copies share storage until one of them is written.
+ *
+ * There is deliberately no non-const operator[]: it would have to detach on every access through a
+ * non-const buffer, even for reads. Writes go through set() or mutable_data().
+ */
+template <typename T, typename RefCount = AtomicRefCount>
+class cow_buffer {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using const_iterator = const T*;
+
+    cow_buffer() = default;
+
+    explicit cow_buffer(size_type count, const T& value = T()) : block_(Block::create(count)) {
+        std::uninitialized_fill_n(block_->data(), count, value);
+        block_->size = count;
+    }
+
+    cow_buffer(std::initializer_list<T> init) : cow_buffer(init.begin(), init.end()) {}
+
+    template <typename It, typename = decltype(*std::declval<It>())>
+    cow_buffer(It first, It last) : block_(Block::create(static_cast<size_type>(std::distance(first, last)))) {
+        std::uninitialized_copy(first, last, block_->data());
+        block_->size = block_->capacity;
+    }
+
+    // Copying shares the block.
+    cow_buffer(const cow_buffer& other) noexcept : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->refs.acquire();
+        }
+    }
+
+    cow_buffer(cow_buffer&& other) noexcept : block_(std::exchange(other.block_, nullptr)) {}
+
+    cow_buffer& operator=(cow_buffer other) noexcept {
+        std::swap(block_, other.block_);
+        return *this;
+    }
+
+    ~cow_buffer() { Block::release(block_); }
+
+    // Read access never copies.
+    const T* data() const { return block_ != nullptr ? block_->data() : nullptr; }
+    const T& operator[](size_type i) const { return block_->data()[i]; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+    size_type size() const { return block_ != nullptr ? block_->size : 0; }
+    bool empty() const { return size() == 0; }
+
+    // Number of buffers sharing the storage (0 for an empty buffer).
+    std::size_t use_count() const { return block_ != nullptr ? block_->refs.count() : 0; }
+    bool is_shared() const { return use_count() > 1; }
+
+    // Write access: detaches first if the storage is shared.
+    T* mutable_data() {
+        if (is_shared()) {
+            detach();
+        }
+        return block_ != nullptr ? block_->data() : nullptr;
+    }
+
+    void set(size_type i, const T& value) { mutable_data()[i] = value; }
+
+    friend bool operator==(const cow_buffer& a, const cow_buffer& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const cow_buffer& a, const cow_buffer& b) { return !(a == b); }
+
+private:
+    // Header and elements in one allocation: [Block][padding][T x capacity].
+    struct Block {
+        RefCount refs;
+        size_type size = 0;
+        size_type capacity = 0;
+
+        static constexpr size_type HeaderBytes = (sizeof(Block) + alignof(T) - 1) / alignof(T) * alignof(T);
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned element types are not supported");
+
+        T* data() { return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(this) + HeaderBytes); }
+
+        static Block* create(size_type capacity) {
+            void* memory = ::operator new(HeaderBytes + capacity * sizeof(T));
+            Block* block = ::new (memory) Block();
+            block->capacity = capacity;
+            return block;
+        }
+
+        // Drop one reference; the last one destroys the elements and frees the block.
+        static void release(Block* block) {
+            if (block != nullptr && block->refs.release()) {
+                std::destroy_n(block->data(), block->size);
+                block->~Block();
+                ::operator delete(static_cast<void*>(block));
+            }
+        }
+    };
+
+    // Replace the shared block with a private copy.
+    void detach() {
+        Block* fresh = Block::create(block_->size);
+        try {
+            std::uninitialized_copy_n(block_->data(), block_->size, fresh->data());
+        } catch (...) {
+            ::operator delete(static_cast<void*>(fresh));
+            throw;
+        }
+        fresh->size = block_->size;
+        Block::release(std::exchange(block_, fresh));
+    }
+
+    Block* block_ = nullptr;
+};
+
+// The payload types compared in the benchmark, with the same read and write operations.
+using SharedVector = std::shared_ptr<const std::vector<int>>;
+
+int readSample(const std::vector<int>& v) { return v[0] + v[v.size() / 2] + v.back(); }
+int readSample(const SharedVector& v) { return readSample(*v); }
+template <typename RefCount>
+int readSample(const cow_buffer<int, RefCount>& v) { return v[0] + v[v.size() / 2] + v[v.size() - 1]; }
+
+// A write in the callee: each type must end up with its own modified copy.
+int writeSample(std::vector<int>& v) {
+    v[0] += 1;
+    return v[0];
+}
+int writeSample(SharedVector& v) {
+    auto copy = std::make_shared<std::vector<int>>(*v); // Immutable: copy by hand.
+    (*copy)[0] += 1;
+    v = std::move(copy);
+    return (*v)[0];
+}
+template <typename RefCount>
+int writeSample(cow_buffer<int, RefCount>& v) {
+    v.set(0, v[0] + 1);
+    return v[0];
+}
+
+// Binary call tree that passes the payload BY VALUE at every call, as an API taking `Payload p` does.
+template <typename Payload>
+long long callTree(Payload payload, int depth, bool leavesWrite) {
+    if (depth == 0) {
+        return leavesWrite ? writeSample(payload) : readSample(payload);
+    }
+    return callTree(payload, depth - 1, leavesWrite) + callTree(payload, depth - 1, leavesWrite);
+}
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+// Time the call tree for each payload type built from the same elements.
+void benchmark(const char* title, std::size_t elements, int depth, bool leavesWrite) {
+    std::vector<int> values(elements);
+    std::iota(values.begin(), values.end(), 0);
+    std::vector<int> vec = values;
+    SharedVector shared = std::make_shared<const std::vector<int>>(values);
+    cow_buffer<int> cow(values.begin(), values.end());
+    cow_buffer<int, LocalRefCount> localCow(values.begin(), values.end());
+
+    std::cout << title << " (" << elements * sizeof(int) << " bytes, " << (2 << depth) - 1 << " calls):\n";
+    auto run = [&](const char* name, auto& payload) {
+        long long result = 0;
+        double ms = bestOfMs(3, [&] { result = callTree(payload, depth, leavesWrite); });
+        std::printf("  %-34s %9.2f ms  (result %lld)\n", name, ms, result);
+    };
+    run("std::vector (deep copy)", vec);
+    run("shared_ptr<const vector>", shared);
+    run("cow_buffer, atomic refcount", cow);
+    run("cow_buffer, non-atomic refcount", localCow);
+}
+
+int main() {
+    // Semantics: copies share until one of them writes.
+    cow_buffer<int> a = {1, 2, 3, 4};
+    cow_buffer<int> b = a;
+    std::cout << "After copy:  a.use_count() = " << a.use_count() << ", same storage: " << std::boolalpha
+              << (a.data() == b.data()) << std::endl;
+    b.set(0, 100);
+    std::cout << "After write: a[0] = " << a[0] << ", b[0] = " << b[0] << ", a.use_count() = " << a.use_count()
+              << std::endl;
+
+    // Copies handed to other threads by value: the atomic count keeps this safe.
+    std::vector<std::thread> readers;
+    std::atomic<long long> checksum{0};
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&checksum](cow_buffer<int> copy) { checksum += std::accumulate(copy.begin(), copy.end(), 0LL); }, a);
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    std::cout << "Checksum from 4 threads: " << checksum << ", a.use_count() = " << a.use_count() << "\n\n";
+
+    benchmark("Large payload, read-only callees", 16 * 1024, 10, false);
+    benchmark("\nLarge payload, every leaf writes", 16 * 1024, 10, true);
+    benchmark("\nTiny payload, read-only callees", 4, 18, false);
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Sharing and detaching:
+ *    - A copy of a cow_buffer costs one increment, whatever the size. The storage is only duplicated
+ *      when a shared buffer is written, so every copy still behaves like an independent value.
+ *    - A buffer that is not shared (use_count() == 1) is written in place. No other thread can
+ *      start sharing it at that moment, because doing so needs a copy of THIS buffer.
+ *
+ * 2. Compared with shared_ptr<const vector>:
+ *    - Both share the data. shared_ptr needs two allocations (or make_shared's combined block plus a
+ *      separate vector buffer) and an extra indirection on every access, and a write needs a
+ *      manual copy. cow_buffer does one allocation and detaches automatically.
+ *
+ * 3. Atomic vs non-atomic count:
+ *    - A locked increment costs roughly 5-20 cycles even without contention. That only matters when
+ *      copies are cheap otherwise, as in the tiny-payload test.
+ *
+ * Tips and Tricks:
+ * - Keep the API const-correct: take `const cow_buffer&` or a by-value cow_buffer for reads and only
+ *   call mutable_data() where a write is really intended.
+ * - Detaching a large buffer is more than a memcpy: blocks above glibc's mmap threshold (128 KB by
+ *   default, adjusted at run time) are fresh mappings whose pages all fault on first write.
+ * - Use LocalRefCount only when copies never cross a thread boundary; sharing one between threads
+ *   is a data race on the count.
+ */
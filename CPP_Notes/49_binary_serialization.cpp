@@ -0,0 +1,533 @@
+/**
+ * @file 49_binary_serialization.cpp
+ * @brief Demonstrates a fixed-layout little-endian binary format that can be read in place.
+ *
+ * `MyClass` in 02_Class_Objec_Initilisation.cpp and 01_inlie_extern_friend.cpp only reaches the
+ * outside world through display() and revealSecret(), which format text. Text is easy to read,
+ * but formatting and parsing numbers costs far more than the data itself, and a text record has
+ * to be parsed completely before any field can be used.
+ *
+ * This program adds a small binary layer, namespace `wire`:
+ *
+ * - **Scalars** (integers, floating point, enums) are stored little-endian with their exact size.
+ *   On little-endian hosts store/load are plain memcpy; big-endian hosts swap the bytes.
+ * - **Field-described classes** list their members once, in a static `wireFields()` function that
+ *   returns a tuple of member pointers. The wire layout is the fields in that order, packed with no
+ *   padding, so every field has a compile-time offset. Described classes can be nested.
+ * - **In-place reading**: `wire::View<T>` reads one field straight from a byte buffer (for example a
+ *   memory-mapped file) with `get<I>()`, without decoding the rest of the record.
+ *   `wire::ArrayView<T>` indexes an encoded array of records.
+ * - **Batch encode/decode**: `encodeArray`/`decodeArray` convert contiguous arrays. When the
+ *   in-memory layout of a trivially copyable type equals its wire layout (little-endian host, same
+ *   field order, no padding), the whole array is a single memcpy.
+ *
+ * The benchmark writes and reads 2M MyClass records as iostream text, as std::to_chars text and in
+ * the binary format, reads one field in place from a memory-mapped file, and also converts a
+ * padded, nested type that needs the per-field path.
+ *
+ * @note POSIX (mmap). Compile with `-std=c++17 -O2`.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wire {
+
+constexpr bool HostIsLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+template <typename T>
+constexpr bool IsScalar = (std::is_arithmetic_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, long double>;
+
+template <typename Member>
+struct MemberTraits;
+
+template <typename Class, typename Field>
+struct MemberTraits<Field Class::*> {
+    using type = Field;
+};
+
+template <typename Member>
+using FieldType = typename MemberTraits<Member>::type;
+
+// Store a scalar as little-endian bytes; out needs no particular alignment.
+template <typename T>
+void store(unsigned char* out, T value) {
+    static_assert(IsScalar<T>, "only fixed-size scalars are stored directly");
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if constexpr (!HostIsLittleEndian) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    std::memcpy(out, bytes, sizeof(T));
+}
+
+template <typename T>
+T load(const unsigned char* in) {
+    static_assert(IsScalar<T>, "only fixed-size scalars are loaded directly");
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, in, sizeof(T));
+    if constexpr (!HostIsLittleEndian) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// Encoded size: sizeof for scalars, the sum of the fields for described classes.
+template <typename T>
+constexpr std::size_t wireSize() {
+    if constexpr (IsScalar<T>) {
+        return sizeof(T);
+    } else {
+        return std::apply(
+            [](auto... members) { return (std::size_t{0} + ... + wireSize<FieldType<decltype(members)>>()); },
+            T::wireFields());
+    }
+}
+
+// Offset of field I inside an encoded T.
+template <typename T, std::size_t I>
+constexpr std::size_t fieldOffset() {
+    if constexpr (I == 0) {
+        return 0;
+    } else {
+        using Previous = FieldType<std::tuple_element_t<I - 1, decltype(T::wireFields())>>;
+        return fieldOffset<T, I - 1>() + wireSize<Previous>();
+    }
+}
+
+template <typename T>
+void encode(const T& value, unsigned char* out) {
+    if constexpr (IsScalar<T>) {
+        store(out, value);
+    } else {
+        std::size_t offset = 0;
+        std::apply(
+            [&](auto... members) {
+                ((encode(value.*members, out + offset), offset += wireSize<FieldType<decltype(members)>>()), ...);
+            },
+            T::wireFields());
+    }
+}
+
+template <typename T>
+void decode(const unsigned char* in, T& value) {
+    if constexpr (IsScalar<T>) {
+        value = load<T>(in);
+    } else {
+        std::size_t offset = 0;
+        std::apply(
+            [&](auto... members) {
+                ((decode(in + offset, value.*members), offset += wireSize<FieldType<decltype(members)>>()), ...);
+            },
+            T::wireFields());
+    }
+}
+
+// True when an array of T in memory is byte-for-byte its encoded form.
+template <typename T>
+bool memoryLayoutIsWireLayout() {
+    if constexpr (IsScalar<T>) {
+        return HostIsLittleEndian;
+    } else if constexpr (!std::is_trivially_copyable_v<T> || sizeof(T) != wireSize<T>()) {
+        return false; // Not memcpy-able, or padding somewhere.
+    } else {
+        static const bool matches = [] {
+            const T probe{};
+            auto base = reinterpret_cast<const unsigned char*>(&probe);
+            std::size_t wireOffset = 0;
+            bool same = true;
+            std::apply([&](auto... members) {
+                ((same = same && reinterpret_cast<const unsigned char*>(&(probe.*members)) - base ==
+                                     static_cast<std::ptrdiff_t>(wireOffset) &&
+                         memoryLayoutIsWireLayout<FieldType<decltype(members)>>(),
+                  wireOffset += wireSize<FieldType<decltype(members)>>()),
+                 ...);
+            }, T::wireFields());
+            return same;
+        }();
+        return matches;
+    }
+}
+
+// Encode `count` values into out, which must have room for count * wireSize<T>() bytes.
+template <typename T>
+void encodeArray(const T* values, std::size_t count, unsigned char* out) {
+    if (memoryLayoutIsWireLayout<T>()) {
+        std::memcpy(out, values, count * sizeof(T));
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        encode(values[i], out + i * wireSize<T>());
+    }
+}
+
+template <typename T>
+void decodeArray(const unsigned char* in, std::size_t count, T* values) {
+    if (memoryLayoutIsWireLayout<T>()) {
+        std::memcpy(static_cast<void*>(values), in, count * sizeof(T));
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        decode(in + i * wireSize<T>(), values[i]);
+    }
+}
+
+/**
+ * @brief Read-only view of one encoded T; fields are loaded on access.
+ */
+template <typename T>
+class View {
+public:
+    explicit View(const unsigned char* bytes) : bytes_(bytes) {}
+
+    // Field I: its value for scalars, a nested View for described classes.
+    template <std::size_t I>
+    auto get() const {
+        using Field = FieldType<std::tuple_element_t<I, decltype(T::wireFields())>>;
+        const unsigned char* at = bytes_ + fieldOffset<T, I>();
+        if constexpr (IsScalar<Field>) {
+            return load<Field>(at);
+        } else {
+            return View<Field>(at);
+        }
+    }
+
+    T decode() const {
+        T value{};
+        wire::decode(bytes_, value);
+        return value;
+    }
+
+private:
+    const unsigned char* bytes_;
+};
+
+/**
+ * @brief An encoded array: a 16-byte header followed by the records.
+ *
+ *     "WIRE" | le<uint32> record size | le<uint64> count | count x record
+ */
+template <typename T>
+class ArrayView {
+public:
+    static constexpr std::size_t HeaderBytes = 16;
+
+    // Validates the header and the buffer size; throws on mismatch.
+    ArrayView(const unsigned char* data, std::size_t bytes) {
+        if (bytes < HeaderBytes || std::memcmp(data, "WIRE", 4) != 0) {
+            throw std::runtime_error("not a wire array");
+        }
+        if (load<std::uint32_t>(data + 4) != wireSize<T>()) {
+            throw std::runtime_error("wire array has a different record size");
+        }
+        count_ = load<std::uint64_t>(data + 8);
+        if ((bytes - HeaderBytes) / wireSize<T>() < count_) {
+            throw std::runtime_error("wire array is truncated");
+        }
+        records_ = data + HeaderBytes;
+    }
+
+    std::size_t size() const { return count_; }
+    View<T> operator[](std::size_t i) const { return View<T>(records_ + i * wireSize<T>()); }
+    const unsigned char* records() const { return records_; }
+
+private:
+    const unsigned char* records_ = nullptr;
+    std::size_t count_ = 0;
+};
+
+// Header plus records, ready to be written to a file or a socket.
+template <typename T>
+std::vector<unsigned char> encodeWithHeader(const std::vector<T>& values) {
+    std::vector<unsigned char> bytes(ArrayView<T>::HeaderBytes + values.size() * wireSize<T>());
+    std::memcpy(bytes.data(), "WIRE", 4);
+    store(bytes.data() + 4, static_cast<std::uint32_t>(wireSize<T>()));
+    store(bytes.data() + 8, static_cast<std::uint64_t>(values.size()));
+    encodeArray(values.data(), values.size(), bytes.data() + ArrayView<T>::HeaderBytes);
+    return bytes;
+}
+
+} // namespace wire
+
+/**
+ * @brief MyClass from 02_Class_Objec_Initilisation.cpp, grown into a small record.
+ */
+class MyClass {
+public:
+    MyClass() = default;
+    MyClass(std::int64_t id, std::int32_t value, std::uint32_t flags, double score)
+        : id(id), value(value), flags(flags), score(score) {}
+
+    void display() const { std::cout << "Value: " << value << " (id " << id << ", score " << score << ")" << std::endl; }
+    std::int32_t getValue() const { return value; }
+
+    // The serialized fields, in wire order. Member pointers to private members are fine here.
+    static constexpr auto wireFields() {
+        return std::make_tuple(&MyClass::id, &MyClass::value, &MyClass::flags, &MyClass::score);
+    }
+
+    // Text form, as display() would print it: "id value flags score".
+    friend std::ostream& operator<<(std::ostream& out, const MyClass& obj) {
+        return out << obj.id << ' ' << obj.value << ' ' << obj.flags << ' ' << obj.score << '\n';
+    }
+    friend std::istream& operator>>(std::istream& in, MyClass& obj) {
+        return in >> obj.id >> obj.value >> obj.flags >> obj.score;
+    }
+    friend char* toChars(char* out, char* end, const MyClass& obj);
+    friend const char* fromChars(const char* in, const char* end, MyClass& obj);
+
+    friend bool operator==(const MyClass& a, const MyClass& b) {
+        return a.id == b.id && a.value == b.value && a.flags == b.flags && a.score == b.score;
+    }
+
+private:
+    std::int64_t id = 0;
+    std::int32_t value = 0;
+    std::uint32_t flags = 0;
+    double score = 0.0;
+};
+
+// The same text with std::to_chars / std::from_chars: no locale, no streams. The parser trusts its
+// input and skips exactly one separator after each number.
+char* toChars(char* out, char* end, const MyClass& obj) {
+    out = std::to_chars(out, end, obj.id).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, end, obj.value).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, end, obj.flags).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, end, obj.score).ptr; // Shortest form that round-trips.
+    *out++ = '\n';
+    return out;
+}
+
+const char* fromChars(const char* in, const char* end, MyClass& obj) {
+    in = std::from_chars(in, end, obj.id).ptr + 1;
+    in = std::from_chars(in, end, obj.value).ptr + 1;
+    in = std::from_chars(in, end, obj.flags).ptr + 1;
+    return std::from_chars(in, end, obj.score).ptr + 1;
+}
+
+// A nested type with padding in memory (1 + 7 padding + 24 bytes), so it takes the per-field path.
+struct Sample {
+    std::uint8_t kind = 0;
+    MyClass item;
+
+    static constexpr auto wireFields() { return std::make_tuple(&Sample::kind, &Sample::item); }
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file, as in 34_mmap_array_view.cpp.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat info {};
+        ::fstat(fd, &info);
+        size_ = static_cast<std::size_t>(info.st_size);
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("cannot map " + path);
+        }
+        data_ = static_cast<const unsigned char*>(p);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { ::munmap(const_cast<unsigned char*>(data_), size_); }
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, double encodeMs, double decodeMs, std::size_t bytes, bool ok) {
+    std::printf("  %-28s %9.1f ms %9.1f ms %9.1f MB  %s\n", name, encodeMs, decodeMs, bytes / 1e6,
+                ok ? "round-trip ok" : "MISMATCH");
+}
+
+int main() {
+    MyClass obj(1, 99, 0, 0.5);
+    obj.display();
+    std::printf("wire size: MyClass %zu bytes (sizeof %zu, memcpy path: %s), Sample %zu bytes (sizeof %zu, memcpy path: %s)\n\n",
+                wire::wireSize<MyClass>(), sizeof(MyClass), wire::memoryLayoutIsWireLayout<MyClass>() ? "yes" : "no",
+                wire::wireSize<Sample>(), sizeof(Sample), wire::memoryLayoutIsWireLayout<Sample>() ? "yes" : "no");
+
+    const std::size_t n = 2'000'000;
+    std::vector<MyClass> records;
+    records.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        records.emplace_back(static_cast<std::int64_t>(i * 7919), static_cast<std::int32_t>(i % 1000),
+                             static_cast<std::uint32_t>(i & 0xFF), static_cast<double>(i) / 3.0);
+    }
+    std::vector<MyClass> decoded(n);
+
+    std::printf("%zu records: %28s %12s %12s\n", n, "encode", "decode", "size");
+
+    // 1. iostream text.
+    std::string text;
+    double encodeMs = timeMs([&] {
+        std::ostringstream out;
+        out.precision(17);
+        for (const MyClass& r : records) {
+            out << r;
+        }
+        text = out.str();
+    });
+    double decodeMs = timeMs([&] {
+        std::istringstream in(text);
+        for (MyClass& r : decoded) {
+            in >> r;
+        }
+    });
+    report("text, iostream", encodeMs, decodeMs, text.size(), decoded == records);
+
+    // 2. to_chars / from_chars text.
+    std::fill(decoded.begin(), decoded.end(), MyClass());
+    std::vector<char> chars(n * 80);
+    char* textEnd = nullptr;
+    encodeMs = timeMs([&] {
+        char* out = chars.data();
+        for (const MyClass& r : records) {
+            out = toChars(out, chars.data() + chars.size(), r);
+        }
+        textEnd = out;
+    });
+    decodeMs = timeMs([&] {
+        const char* in = chars.data();
+        for (MyClass& r : decoded) {
+            in = fromChars(in, textEnd, r);
+        }
+    });
+    report("text, to_chars/from_chars", encodeMs, decodeMs, static_cast<std::size_t>(textEnd - chars.data()),
+           decoded == records);
+
+    // 3. Binary, one record at a time through the field description.
+    std::fill(decoded.begin(), decoded.end(), MyClass());
+    std::vector<unsigned char> binary(n * wire::wireSize<MyClass>());
+    encodeMs = timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            wire::encode(records[i], binary.data() + i * wire::wireSize<MyClass>());
+        }
+    });
+    decodeMs = timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            wire::decode(binary.data() + i * wire::wireSize<MyClass>(), decoded[i]);
+        }
+    });
+    report("binary, per record", encodeMs, decodeMs, binary.size(), decoded == records);
+
+    // 4. Binary batch: a single memcpy for MyClass on little-endian hosts.
+    std::fill(decoded.begin(), decoded.end(), MyClass());
+    encodeMs = timeMs([&] { wire::encodeArray(records.data(), n, binary.data()); });
+    decodeMs = timeMs([&] { wire::decodeArray(binary.data(), n, decoded.data()); });
+    report("binary, encodeArray", encodeMs, decodeMs, binary.size(), decoded == records);
+
+    // 5. Padded, nested type: batch calls fall back to the per-field path.
+    std::vector<Sample> samples(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        samples[i] = Sample{static_cast<std::uint8_t>(i % 3), records[i]};
+    }
+    std::vector<Sample> samplesBack(n);
+    std::vector<unsigned char> sampleBytes(n * wire::wireSize<Sample>());
+    encodeMs = timeMs([&] { wire::encodeArray(samples.data(), n, sampleBytes.data()); });
+    decodeMs = timeMs([&] { wire::decodeArray(sampleBytes.data(), n, samplesBack.data()); });
+    bool samplesOk = std::equal(samples.begin(), samples.end(), samplesBack.begin(),
+                                [](const Sample& a, const Sample& b) { return a.kind == b.kind && a.item == b.item; });
+    report("binary, Sample (padded)", encodeMs, decodeMs, sampleBytes.size(), samplesOk);
+
+    // 6. In place from a memory-mapped file: sum one field without decoding the records.
+    const std::string path = "records.wire";
+    {
+        std::vector<unsigned char> file = wire::encodeWithHeader(records);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()),
+                                                    static_cast<std::streamsize>(file.size()));
+    }
+    long long expected = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        expected += static_cast<long long>(i % 1000);
+    }
+    {
+        MappedFile mapped(path);
+        wire::ArrayView<MyClass> view(mapped.data(), mapped.size());
+        long long inPlace = 0;
+        double viewMs = timeMs([&] {
+            for (std::size_t i = 0; i < view.size(); ++i) {
+                inPlace += view[i].get<1>(); // MyClass::value
+            }
+        });
+        long long viaDecode = 0;
+        double decodeAllMs = timeMs([&] {
+            std::vector<MyClass> all(view.size());
+            wire::decodeArray(view.records(), view.size(), all.data());
+            for (const MyClass& r : all) {
+                viaDecode += r.getValue();
+            }
+        });
+        std::printf("\nMapped file, sum of MyClass::value over %zu records:\n", view.size());
+        std::printf("  %-28s %9.1f ms  %s\n", "in place, View::get<1>()", viewMs, inPlace == expected ? "ok" : "WRONG");
+        std::printf("  %-28s %9.1f ms  %s\n", "decodeArray, then sum", decodeAllMs, viaDecode == expected ? "ok" : "WRONG");
+    }
+    std::remove(path.c_str());
+
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Fixed layout:
+ *    - Every field has a fixed size and a compile-time offset, and byte order is always little
+ *      endian. A reader on any machine can find field I of record k at
+ *      header + k * wireSize + fieldOffset<T, I>() without parsing anything before it.
+ *
+ * 2. Why in-place reading works:
+ *    - load() copies sizeof(T) bytes with memcpy, which has no alignment requirement. On x86 and
+ *      ARM64 the compiler turns it into one ordinary load instruction.
+ *
+ * 3. Batch fast path:
+ *    - If T is trivially copyable, has no padding and its members are in wire order, memory and wire
+ *      layouts are identical on a little-endian host, so converting an array is one memcpy.
+ *      Otherwise each field is copied separately, which is still far cheaper than text.
+ *
+ * Tips and Tricks:
+ * - Add a version field to the header before the format is used for persisted data.
+ * - Validate sizes before trusting a buffer from outside (ArrayView's constructor does).
+ * - Variable-length data (strings) does not fit a fixed layout; store it in a separate section
+ *   and keep an offset and a length in the record.
+ */
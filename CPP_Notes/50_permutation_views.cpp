@@ -0,0 +1,343 @@
+/**
+ * @file 50_permutation_views.cpp
+ * @brief Demonstrates sorting large records through an index permutation instead of moving them.
+ *
+ * 18_address&.cpp uses references as aliases, so a function can work on a variable without copying
+ * it. The same idea helps when a huge array of big records has to be ordered by a key: sorting
+ * the records themselves moves every record about log2(n) times, and each move copies the whole
+ * record.
+ *
+ * This program sorts a small array of indices instead:
+ *
+ * - `argsort(records, n, key)` returns the permutation that orders the records by key. It copies
+ *   the (key, index) pairs into a compact array and sorts that, instead of sorting indices with a
+ *   comparator that jumps into the big records on every comparison.
+ * - `PermutedView<T>` iterates or indexes the records in permuted order. Element i is
+ *   records[perm[i]], a reference to the original record; nothing moves.
+ * - `applyPermutation(records, perm, n)` reorders the records in place when a physical order is
+ *   finally needed. It follows each cycle of the permutation, so every record moves exactly once
+ *   and only one record is held aside per cycle. The jumps along a cycle are random accesses, so
+ *   the cache-aware version walks the cycle a few steps ahead and prefetches those records, as in
+ *   44_prefetch_traversal.cpp.
+ *
+ * The benchmark compares std::sort on 256-byte records against argsort (both ways), iteration
+ * through the view, and the in-place and out-of-place ways to apply the permutation.
+ *
+ * @note Compile with `-std=c++17 -O2`. __builtin_prefetch is a GCC/Clang builtin.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A 256-byte record: a sort key plus a payload that makes every move expensive.
+ */
+struct Record {
+    std::uint32_t key = 0;
+    std::uint32_t id = 0;
+    double values[31] = {};
+};
+
+static_assert(sizeof(Record) == 256, "four cache lines per record");
+
+using Permutation = std::vector<std::uint32_t>;
+
+// Stable argsort: result[i] is the index of the i-th smallest key.
+template <typename T, typename KeyFn>
+Permutation argsort(const T* records, std::size_t n, KeyFn key) {
+    using Key = decltype(key(records[0]));
+    Permutation perm(n);
+    if constexpr (std::is_unsigned_v<Key> && sizeof(Key) <= 4) {
+        // Pack key and index into one 64-bit integer: a single integer compare per comparison.
+        std::vector<std::uint64_t> keyed(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            keyed[i] = std::uint64_t{key(records[i])} << 32 | i; // One sequential pass over the records.
+        }
+        std::sort(keyed.begin(), keyed.end()); // Ties are ordered by index, hence stable.
+        for (std::size_t i = 0; i < n; ++i) {
+            perm[i] = static_cast<std::uint32_t>(keyed[i]);
+        }
+    } else {
+        std::vector<std::pair<Key, std::uint32_t>> keyed(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            keyed[i] = {key(records[i]), static_cast<std::uint32_t>(i)};
+        }
+        std::sort(keyed.begin(), keyed.end());
+        for (std::size_t i = 0; i < n; ++i) {
+            perm[i] = keyed[i].second;
+        }
+    }
+    return perm;
+}
+
+// The textbook version: sort indices, comparing through the records. Every comparison is two
+// random accesses into the big array.
+template <typename T, typename KeyFn>
+Permutation argsortIndirect(const T* records, std::size_t n, KeyFn key) {
+    Permutation perm(n);
+    std::iota(perm.begin(), perm.end(), 0u);
+    std::stable_sort(perm.begin(), perm.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return key(records[a]) < key(records[b]); });
+    return perm;
+}
+
+/**
+ * @brief Records seen through a permutation: element i is records[perm[i]].
+ */
+template <typename T>
+class PermutedView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        iterator(T* records, const std::uint32_t* index) : records_(records), index_(index) {}
+
+        reference operator*() const { return records_[*index_]; }
+        pointer operator->() const { return &records_[*index_]; }
+        reference operator[](difference_type i) const { return records_[index_[i]]; }
+        iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++index_;
+            return old;
+        }
+        iterator& operator--() {
+            --index_;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator old = *this;
+            --index_;
+            return old;
+        }
+        iterator& operator+=(difference_type d) {
+            index_ += d;
+            return *this;
+        }
+        iterator& operator-=(difference_type d) {
+            index_ -= d;
+            return *this;
+        }
+        friend iterator operator+(iterator it, difference_type d) { return it += d; }
+        friend iterator operator+(difference_type d, iterator it) { return it += d; }
+        friend iterator operator-(iterator it, difference_type d) { return it -= d; }
+        friend difference_type operator-(const iterator& a, const iterator& b) { return a.index_ - b.index_; }
+        friend bool operator==(const iterator& a, const iterator& b) { return a.index_ == b.index_; }
+        friend bool operator!=(const iterator& a, const iterator& b) { return a.index_ != b.index_; }
+        friend bool operator<(const iterator& a, const iterator& b) { return a.index_ < b.index_; }
+        friend bool operator>(const iterator& a, const iterator& b) { return a.index_ > b.index_; }
+        friend bool operator<=(const iterator& a, const iterator& b) { return a.index_ <= b.index_; }
+        friend bool operator>=(const iterator& a, const iterator& b) { return a.index_ >= b.index_; }
+
+    private:
+        T* records_ = nullptr;
+        const std::uint32_t* index_ = nullptr;
+    };
+
+    PermutedView(T* records, const Permutation& perm) : records_(records), perm_(&perm) {}
+
+    std::size_t size() const { return perm_->size(); }
+    T& operator[](std::size_t i) const { return records_[(*perm_)[i]]; }
+    iterator begin() const { return {records_, perm_->data()}; }
+    iterator end() const { return {records_, perm_->data() + perm_->size()}; }
+
+private:
+    T* records_;
+    const Permutation* perm_;
+};
+
+// Out-of-place: out[i] = records[perm[i]]. Sequential writes, random reads, twice the memory.
+template <typename T>
+void gatherInto(const T* records, const Permutation& perm, T* out) {
+    for (std::size_t i = 0; i < perm.size(); ++i) {
+        out[i] = records[perm[i]];
+    }
+}
+
+// Hint the cache to load all of *p (records can span several lines).
+template <typename T>
+inline void prefetchObject(const T* p) {
+    for (std::size_t offset = 0; offset < sizeof(T); offset += 64) {
+        __builtin_prefetch(reinterpret_cast<const char*>(p) + offset);
+    }
+}
+
+/**
+ * @brief In place: afterwards records[i] is the old records[perm[i]], the same result as gatherInto.
+ *
+ * Each cycle i -> perm[i] -> perm[perm[i]] -> ... is rotated by one position: the first record
+ * is held aside, every other record moves once to the slot before it in the cycle. With
+ * Lookahead > 0 the loop keeps a second cursor that many steps ahead on the cycle and prefetches
+ * the record it will move there. Uses one bit per record to mark finished slots.
+ */
+template <std::size_t Lookahead = 0, typename T>
+void applyPermutation(T* records, const Permutation& perm) {
+    std::vector<bool> done(perm.size(), false);
+    for (std::size_t start = 0; start < perm.size(); ++start) {
+        if (done[start] || perm[start] == start) {
+            continue;
+        }
+        std::size_t ahead = start;
+        if constexpr (Lookahead > 0) {
+            for (std::size_t step = 0; step < Lookahead; ++step) {
+                ahead = perm[ahead];
+                prefetchObject(&records[ahead]);
+            }
+        }
+        T held = std::move(records[start]);
+        std::size_t slot = start;
+        for (std::size_t from = perm[slot]; from != start; from = perm[slot]) {
+            if constexpr (Lookahead > 0) {
+                ahead = perm[ahead];
+                prefetchObject(&records[ahead]);
+            }
+            records[slot] = std::move(records[from]);
+            done[slot] = true;
+            slot = from;
+        }
+        records[slot] = std::move(held);
+        done[slot] = true;
+    }
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    // References through a permutation, like the aliases of 18_address&.cpp.
+    int scores[] = {30, 10, 20};
+    Permutation order = argsort(scores, 3, [](int s) { return s; });
+    for (int& s : PermutedView<int>(scores, order)) {
+        s += 1; // Modifies the original element.
+    }
+    std::printf("Order: %u %u %u, scores after +1 through the view: %d %d %d\n", order[0], order[1], order[2],
+                scores[0], scores[1], scores[2]);
+
+    // The iterators are random access, so standard algorithms work through the view as well.
+    PermutedView<int> ranked(scores, order);
+    std::reverse(ranked.begin(), ranked.end()); // Swaps the originals in rank order.
+    std::printf("After std::reverse through the view: %d %d %d\n\n", scores[0], scores[1], scores[2]);
+
+    const std::size_t n = std::size_t{1} << 21; // 2M records x 256 bytes = 512 MB
+    std::vector<Record> original(n);
+    std::mt19937 rng(50);
+    for (std::size_t i = 0; i < n; ++i) {
+        original[i].key = rng() % 1000000; // Duplicates on purpose.
+        original[i].id = static_cast<std::uint32_t>(i);
+        original[i].values[0] = static_cast<double>(i);
+    }
+    auto byKey = [](const Record& r) { return r.key; };
+    std::printf("%zu records of %zu bytes (%zu MB)\n\n", n, sizeof(Record), n * sizeof(Record) >> 20);
+
+    auto keyLess = [](const Record& a, const Record& b) { return a.key < b.key; };
+    std::vector<Record> work = original;
+    double directMs = timeMs([&] { std::sort(work.begin(), work.end(), keyLess); });
+    bool directSorted = std::is_sorted(work.begin(), work.end(), keyLess);
+    std::printf("Sorting the records themselves:\n  %-38s %8.1f ms  %s\n", "std::sort(records)", directMs,
+                directSorted ? "sorted" : "WRONG");
+
+    Permutation perm;
+    Permutation permIndirect;
+    double argsortMs = timeMs([&] { perm = argsort(original.data(), n, byKey); });
+    double indirectMs = timeMs([&] { permIndirect = argsortIndirect(original.data(), n, byKey); });
+    std::printf("\nArgsort (records do not move):\n");
+    std::printf("  %-38s %8.1f ms\n", "argsort, sorted (key, index) pairs", argsortMs);
+    std::printf("  %-38s %8.1f ms  %s\n", "stable_sort(indices), key via records", indirectMs,
+                permIndirect == perm ? "same permutation" : "DIFFERENT");
+
+    // Reading through the view: every record is a random access.
+    PermutedView<const Record> view(original.data(), perm);
+    double sum = 0;
+    double viewMs = timeMs([&] {
+        for (const Record& r : view) {
+            sum += r.values[0];
+        }
+    });
+    double sortedSum = 0;
+    double sequentialMs = timeMs([&] {
+        for (const Record& r : work) {
+            sortedSum += r.values[0];
+        }
+    });
+    std::printf("\nOne pass over all records in key order:\n");
+    std::printf("  %-38s %8.1f ms\n", "through PermutedView", viewMs);
+    std::printf("  %-38s %8.1f ms  (sums %s)\n", "over physically sorted records", sequentialMs,
+                sum == sortedSum ? "equal" : "differ");
+
+    // Making the order physical.
+    std::vector<Record> expected(n);
+    std::printf("\nApplying the permutation:\n");
+    double gatherMs = timeMs([&] { gatherInto(original.data(), perm, expected.data()); });
+    std::printf("  %-38s %8.1f ms  (needs a second array)\n", "gather into a new array", gatherMs);
+
+    auto checkApplied = [&](const std::vector<Record>& records) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (records[i].id != expected[i].id) {
+                return false;
+            }
+        }
+        return true;
+    };
+    work = original;
+    double cycleMs = timeMs([&] { applyPermutation(work.data(), perm); });
+    std::printf("  %-38s %8.1f ms  %s\n", "in place, cycle following", cycleMs, checkApplied(work) ? "ok" : "WRONG");
+    work = original;
+    double prefetchMs = timeMs([&] { applyPermutation<8>(work.data(), perm); });
+    std::printf("  %-38s %8.1f ms  %s\n", "in place, cycles + prefetch 8 ahead", prefetchMs,
+                checkApplied(work) ? "ok" : "WRONG");
+
+    std::printf("\nargsort + in-place apply: %.1f ms vs std::sort(records): %.1f ms\n", argsortMs + prefetchMs, directMs);
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Why sort indices:
+ *    - std::sort moves records O(n log n) times. argsort moves 8-byte (key, index) pairs instead and
+ *      reads each big record exactly once. Applying the permutation afterwards moves each record
+ *      exactly once.
+ *    - The break-even point depends on the record size: std::sort's partitioning streams through
+ *      memory, so for small records sorting them directly is as fast. The bigger the records, the
+ *      more argsort + apply wins.
+ *    - Comparing through the records (stable_sort of indices with a key lookup) reads a random
+ *      record on every comparison; copying the keys next to the indices first avoids that.
+ *
+ * 2. Cycle following:
+ *    - A permutation splits into disjoint cycles. Rotating each cycle by one position puts every
+ *      record of that cycle in place, so the whole reorder needs one temporary record and one
+ *      bit per slot.
+ *
+ * 3. Cache awareness:
+ *    - Consecutive steps of a cycle are random positions in the array. Walking a second cursor a
+ *      few steps ahead is cheap (the perm array is small) and lets the prefetches overlap the
+ *      misses of the current moves.
+ *
+ * Tips and Tricks:
+ * - If the data is only read in the new order once or twice, keep the view and never move
+ *   anything.
+ * - If memory allows, the out-of-place gather is simple and has sequential writes.
+ * - For integer keys, radixSort from 45_radix_sort.cpp sorts the (key, index) pairs even faster.
+ */
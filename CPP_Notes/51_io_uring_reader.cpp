@@ -0,0 +1,589 @@
+/**
+ * @file 51_io_uring_reader.cpp
+ * @brief Demonstrates an asynchronous file reader that keeps several reads in flight with io_uring.
+ *
+ * The lesson programs fill their arrays from initializer lists, and printVector in 13_raw_arrays.cpp
+ * walks memory that is already there. Reading the same data from a file with blocking calls
+ * (`std::ifstream::read`, `read()`) alternates between two idle states: the CPU waits while the
+ * disk works, then the disk waits while the CPU processes the block.
+ *
+ * `AsyncFileReader` keeps `queueDepth` reads of `blockSize` bytes in flight and hands completed
+ * blocks to a consumer callback strictly in file order:
+ *
+ * - **io_uring backend** (Linux 5.6+): submission and completion rings shared with the kernel, set
+ *   up with the raw io_uring_setup/io_uring_enter system calls and <linux/io_uring.h>, so no
+ *   liburing is needed. Each free buffer gets an IORING_OP_READ; completions may arrive in any
+ *   order and are matched to buffers by their user_data. After the consumer returns a buffer it
+ *   is immediately resubmitted for the block `queueDepth` positions ahead.
+ * - **Thread-pool backend** (fallback when io_uring is unavailable, e.g. disabled by seccomp, or
+ *   too old: kernels 5.1-5.5 create rings but reject IORING_OP_READ, which is detected up front
+ *   with IORING_REGISTER_PROBE): `queueDepth` threads issue blocking pread() calls into the same
+ *   ring of buffers.
+ * - **O_DIRECT** (optional): buffers, offsets and lengths are aligned to 4096 bytes so reads can
+ *   bypass the page cache and go straight from the device into our buffers. A short read is
+ *   resumed from the last aligned offset, re-reading the few bytes past it.
+ *
+ * The benchmark writes a 512 MB file, drops it from the page cache before every run, and compares
+ * MB/s and CPU usage of std::ifstream, the thread pool and io_uring (buffered and O_DIRECT, with
+ * several queue depths).
+ *
+ * @note Linux only. Compile with `-std=c++17 -O2 -pthread`.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Minimal io_uring wrapper: one submission queue, one completion queue, reads only.
+ *
+ * The kernel and this process share the ring memory. The tails and heads are read and written
+ * with acquire/release atomics: the kernel must see a complete SQE before it sees the new tail, and
+ * we must see a complete CQE once we see the kernel's new tail.
+ */
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params params{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+        sqBytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqBytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        singleMmap_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap_) {
+            sqBytes_ = cqBytes_ = std::max(sqBytes_, cqBytes_);
+        }
+        sqRing_ = mapRing(sqBytes_, IORING_OFF_SQ_RING);
+        cqRing_ = singleMmap_ ? sqRing_ : mapRing(cqBytes_, IORING_OFF_CQ_RING);
+        sqeBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(mapRing(sqeBytes_, IORING_OFF_SQES));
+
+        auto* sq = static_cast<unsigned char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = static_cast<unsigned char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        ::munmap(sqes_, sqeBytes_);
+        if (!singleMmap_) {
+            ::munmap(cqRing_, cqBytes_);
+        }
+        ::munmap(sqRing_, sqBytes_);
+        ::close(fd_);
+    }
+
+    // Whether the kernel implements IORING_OP_READ. The probe itself arrived in 5.6 together with
+    // IORING_OP_READ, so a kernel that rejects the probe cannot do plain reads either.
+    bool supportsRead() const {
+        constexpr unsigned maxOps = 256;
+        std::vector<unsigned char> memory(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+        if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, maxOps) < 0) {
+            return false;
+        }
+        return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    // Queue one read and hand it to the kernel right away.
+    void submitRead(int fd, void* buffer, unsigned length, std::uint64_t offset, std::uint64_t userData) {
+        unsigned tail = *sqTail_; // Only this thread writes the tail.
+        unsigned index = tail & sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        enter(1, 0, 0);
+    }
+
+    // Block until at least one completion is available.
+    void waitForCompletion() { enter(0, 1, IORING_ENTER_GETEVENTS); }
+
+    // Pass every available completion to fn(userData, result); result is bytes read or -errno.
+    template <typename Fn>
+    void drainCompletions(Fn&& fn) {
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe cqe = cqes_[head & cqMask_];
+            // Release the entry before fn runs, so a throwing fn does not see it again.
+            __atomic_store_n(cqHead_, ++head, __ATOMIC_RELEASE);
+            fn(cqe.user_data, cqe.res);
+        }
+    }
+
+private:
+    void* mapRing(std::size_t bytes, off_t offset) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (p == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+        }
+        return p;
+    }
+
+    void enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        while (::syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete, flags, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+        }
+    }
+
+    int fd_ = -1;
+    bool singleMmap_ = false;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqBytes_ = 0;
+    std::size_t cqBytes_ = 0;
+    std::size_t sqeBytes_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+/**
+ * @brief Reads a whole file with several reads in flight; the consumer sees the blocks in order.
+ */
+class AsyncFileReader {
+public:
+    enum class Backend { Auto, IoUring, ThreadPool };
+
+    struct Options {
+        std::size_t blockSize = 1 << 20; // Multiple of Alignment.
+        unsigned queueDepth = 8;
+        bool direct = false; // O_DIRECT; silently falls back to buffered I/O if unsupported.
+        Backend backend = Backend::Auto;
+    };
+
+    // consumer(data, bytes, fileOffset) is called once per block, in file order, on the caller's thread.
+    using Consumer = std::function<void(const unsigned char*, std::size_t, std::uint64_t)>;
+
+    static constexpr std::size_t Alignment = 4096;
+
+    explicit AsyncFileReader(Options options) : options_(options) {
+        if (options_.blockSize == 0 || options_.blockSize % Alignment != 0 || options_.queueDepth == 0) {
+            throw std::invalid_argument("blockSize must be a non-zero multiple of 4096 and queueDepth > 0");
+        }
+    }
+
+    // Reads the file; returns the backend that was actually used.
+    Backend read(const std::string& path, const Consumer& consumer) {
+        int fd = ::open(path.c_str(), O_RDONLY | (options_.direct ? O_DIRECT : 0));
+        if (fd < 0 && options_.direct) {
+            fd = ::open(path.c_str(), O_RDONLY); // The file system does not support O_DIRECT.
+        }
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct FdCloser {
+            int fd;
+            ~FdCloser() { ::close(fd); }
+        } closer{fd};
+        struct stat info {};
+        ::fstat(fd, &info);
+        std::uint64_t fileSize = static_cast<std::uint64_t>(info.st_size);
+
+        // One allocation for all slots, aligned for O_DIRECT.
+        void* memory = nullptr;
+        if (::posix_memalign(&memory, Alignment, options_.blockSize * options_.queueDepth) != 0) {
+            throw std::bad_alloc();
+        }
+        std::unique_ptr<unsigned char, decltype(&std::free)> buffers(static_cast<unsigned char*>(memory), &std::free);
+
+        if (options_.backend != Backend::ThreadPool) {
+            std::unique_ptr<IoUring> ring;
+            try {
+                ring = std::make_unique<IoUring>(options_.queueDepth);
+            } catch (const std::system_error&) {
+                if (options_.backend == Backend::IoUring) {
+                    throw;
+                }
+            }
+            if (ring && !ring->supportsRead()) {
+                if (options_.backend == Backend::IoUring) {
+                    throw std::system_error(EINVAL, std::generic_category(), "io_uring: IORING_OP_READ not supported");
+                }
+                ring.reset(); // Kernel 5.1-5.5: the ring works, but every read would fail with -EINVAL.
+            }
+            if (ring) {
+                readWithIoUring(*ring, fd, fileSize, buffers.get(), consumer);
+                return Backend::IoUring;
+            }
+        }
+        readWithThreadPool(fd, fileSize, buffers.get(), consumer);
+        return Backend::ThreadPool;
+    }
+
+private:
+    // Bytes of block `block` that exist in the file, and the length to request (aligned for O_DIRECT).
+    std::size_t blockBytes(std::uint64_t fileSize, std::uint64_t block) const {
+        std::uint64_t remaining = fileSize - block * options_.blockSize;
+        return static_cast<std::size_t>(std::min<std::uint64_t>(options_.blockSize, remaining));
+    }
+    static std::size_t roundUp(std::size_t bytes) { return (bytes + Alignment - 1) / Alignment * Alignment; }
+    // Where to resume after a short read: O_DIRECT offsets must be aligned, so step back to the
+    // last aligned byte and read the tail of the partial page again.
+    std::size_t resumeAt(std::size_t filled) const { return options_.direct ? filled / Alignment * Alignment : filled; }
+
+    void readWithIoUring(IoUring& ring, int fd, std::uint64_t fileSize, unsigned char* buffers,
+                         const Consumer& consumer) {
+        const std::uint64_t blocks = (fileSize + options_.blockSize - 1) / options_.blockSize;
+        const unsigned depth = options_.queueDepth;
+        struct Slot {
+            std::uint64_t block = 0;
+            std::size_t filled = 0;
+            bool complete = false;
+        };
+        std::vector<Slot> slots(depth);
+        unsigned inFlight = 0;
+        auto submit = [&](unsigned slot, std::uint64_t block) {
+            slots[slot] = Slot{block, 0, false};
+            auto length = static_cast<unsigned>(roundUp(blockBytes(fileSize, block)));
+            ring.submitRead(fd, buffers + slot * options_.blockSize, length, block * options_.blockSize, slot);
+            ++inFlight;
+        };
+        auto onCompletion = [&](std::uint64_t slotIndex, int result) {
+            --inFlight;
+            Slot& slot = slots[slotIndex];
+            std::size_t wanted = blockBytes(fileSize, slot.block);
+            if (result < 0) {
+                throw std::system_error(-result, std::generic_category(), "io_uring read");
+            }
+            if (result == 0) {
+                throw std::runtime_error("unexpected end of file");
+            }
+            slot.filled += static_cast<std::size_t>(result);
+            if (slot.filled >= wanted) {
+                slot.complete = true;
+                return;
+            }
+            // Short read (rare for regular files): request the rest.
+            slot.filled = resumeAt(slot.filled);
+            std::size_t rest = wanted - slot.filled;
+            ring.submitRead(fd, buffers + slotIndex * options_.blockSize + slot.filled,
+                            static_cast<unsigned>(options_.direct ? roundUp(rest) : rest),
+                            slot.block * options_.blockSize + slot.filled, slotIndex);
+            ++inFlight;
+        };
+
+        try {
+            for (unsigned s = 0; s < depth && s < blocks; ++s) {
+                submit(s, s);
+            }
+            for (std::uint64_t next = 0; next < blocks; ++next) {
+                unsigned slot = static_cast<unsigned>(next % depth);
+                ring.drainCompletions(onCompletion);
+                while (!slots[slot].complete) {
+                    ring.waitForCompletion();
+                    ring.drainCompletions(onCompletion);
+                }
+                consumer(buffers + slot * options_.blockSize, blockBytes(fileSize, next), next * options_.blockSize);
+                if (next + depth < blocks) {
+                    submit(slot, next + depth); // Reuse the buffer for the block depth positions ahead.
+                }
+            }
+        } catch (...) {
+            // The kernel may still be writing into the buffers: wait for every read before they are freed.
+            while (inFlight > 0) {
+                ring.waitForCompletion();
+                ring.drainCompletions([&](std::uint64_t, int) { --inFlight; });
+            }
+            throw;
+        }
+    }
+
+    void readWithThreadPool(int fd, std::uint64_t fileSize, unsigned char* buffers, const Consumer& consumer) {
+        const std::uint64_t blocks = (fileSize + options_.blockSize - 1) / options_.blockSize;
+        const unsigned depth = options_.queueDepth;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<std::int64_t> readyBlock(depth, -1); // Block whose data is in the slot, or -1.
+        std::uint64_t nextToRead = 0;
+        std::uint64_t consumed = 0;
+        std::string error;
+
+        auto worker = [&] {
+            for (;;) {
+                std::uint64_t block;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    // A slot is free once the block depth positions earlier has been consumed.
+                    changed.wait(lock, [&] {
+                        return nextToRead >= blocks || nextToRead < consumed + depth || !error.empty();
+                    });
+                    if (nextToRead >= blocks || !error.empty()) {
+                        return;
+                    }
+                    block = nextToRead++;
+                }
+                unsigned char* buffer = buffers + (block % depth) * options_.blockSize;
+                std::size_t wanted = blockBytes(fileSize, block);
+                std::size_t filled = 0;
+                std::string failure;
+                while (filled < wanted) {
+                    filled = resumeAt(filled);
+                    std::size_t length = options_.direct ? roundUp(wanted - filled) : wanted - filled;
+                    auto offset = static_cast<off_t>(block * options_.blockSize + filled);
+                    ssize_t n = ::pread(fd, buffer + filled, length, offset);
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n <= 0) {
+                        failure = n < 0 ? std::strerror(errno) : "unexpected end of file";
+                        break;
+                    }
+                    filled += static_cast<std::size_t>(n);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failure.empty()) {
+                        error = "pread: " + failure;
+                    } else {
+                        readyBlock[block % depth] = static_cast<std::int64_t>(block);
+                    }
+                }
+                changed.notify_all();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < depth; ++t) {
+            pool.emplace_back(worker);
+        }
+
+        for (std::uint64_t next = 0; next < blocks; ++next) {
+            unsigned slot = static_cast<unsigned>(next % depth);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] {
+                    return readyBlock[slot] == static_cast<std::int64_t>(next) || !error.empty();
+                });
+                if (!error.empty()) {
+                    break;
+                }
+            }
+            try {
+                consumer(buffers + slot * options_.blockSize, blockBytes(fileSize, next), next * options_.blockSize);
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    error = "consumer failed";
+                }
+                changed.notify_all();
+                for (auto& thread : pool) {
+                    thread.join();
+                }
+                throw;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                readyBlock[slot] = -1;
+                consumed = next + 1;
+            }
+            changed.notify_all();
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    Options options_;
+};
+
+// Drops the file's pages from the OS page cache, as in 34_mmap_array_view.cpp.
+void evictFromPageCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+// User + system CPU time of the whole process, all threads included.
+double cpuSeconds() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& t) { return static_cast<double>(t.tv_sec) + t.tv_usec / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// Runs read(consumer) on a cold page cache and prints throughput and CPU usage.
+template <typename Read>
+void measure(const char* label, const std::string& path, std::uint64_t bytes, Read read) {
+    evictFromPageCache(path);
+    long long sum = 0;
+    auto consumer = [&sum](const unsigned char* data, std::size_t size, std::uint64_t) {
+        // The work done per block: sum the ints, as printVector would walk them.
+        const int* values = reinterpret_cast<const int*>(data);
+        sum = std::accumulate(values, values + size / sizeof(int), sum);
+    };
+    double cpuStart = cpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    std::string note = read(consumer);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = cpuSeconds() - cpuStart;
+    std::printf("  %-34s %8.1f MB/s  CPU %5.1f%%  sum %lld %s\n", label, bytes / seconds / 1e6, 100.0 * cpu / seconds,
+                sum, note.c_str());
+}
+
+int main() {
+    const std::string path = "io_uring_reader_bench.bin";
+    const std::size_t count = std::size_t{128} << 20; // 128M ints = 512 MB
+    {
+        std::vector<int> values(count / 8);
+        std::ofstream out(path, std::ios::binary);
+        for (int part = 0; part < 8; ++part) {
+            std::iota(values.begin(), values.end(), static_cast<int>(part * values.size()));
+            out.write(reinterpret_cast<const char*>(values.data()),
+                      static_cast<std::streamsize>(values.size() * sizeof(int)));
+        }
+    }
+    const std::uint64_t bytes = count * sizeof(int);
+
+    // The consumer sees the blocks in file order: print the first elements, like printVector.
+    AsyncFileReader reader(AsyncFileReader::Options{});
+    bool first = true;
+    AsyncFileReader::Backend used = reader.read(path, [&first](const unsigned char* data, std::size_t, std::uint64_t) {
+        if (first) {
+            const int* values = reinterpret_cast<const int*>(data);
+            std::cout << "First elements: " << values[0] << " " << values[1] << " " << values[2] << std::endl;
+            first = false;
+        }
+    });
+    bool usedIoUring = used == AsyncFileReader::Backend::IoUring;
+    std::cout << "Default backend: " << (usedIoUring ? "io_uring" : "thread pool") << "\n\n";
+
+    std::printf("Reading %llu MB from a cold page cache:\n", static_cast<unsigned long long>(bytes >> 20));
+    measure("std::ifstream, 1 MB reads", path, bytes, [&](auto& consumer) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<unsigned char> block(1 << 20);
+        std::uint64_t offset = 0;
+        auto blockBytes = static_cast<std::streamsize>(block.size());
+        while (in.read(reinterpret_cast<char*>(block.data()), blockBytes) || in.gcount() > 0) {
+            consumer(block.data(), static_cast<std::size_t>(in.gcount()), offset);
+            offset += static_cast<std::uint64_t>(in.gcount());
+        }
+        return std::string();
+    });
+
+    struct Config {
+        const char* label;
+        AsyncFileReader::Backend backend;
+        unsigned depth;
+        bool direct;
+    };
+    const Config configs[] = {
+        {"thread pool, depth 8", AsyncFileReader::Backend::ThreadPool, 8, false},
+        {"thread pool, depth 8, O_DIRECT", AsyncFileReader::Backend::ThreadPool, 8, true},
+        {"io_uring, depth 1", AsyncFileReader::Backend::IoUring, 1, false},
+        {"io_uring, depth 8", AsyncFileReader::Backend::IoUring, 8, false},
+        {"io_uring, depth 1, O_DIRECT", AsyncFileReader::Backend::IoUring, 1, true},
+        {"io_uring, depth 8, O_DIRECT", AsyncFileReader::Backend::IoUring, 8, true},
+        {"io_uring, depth 32, O_DIRECT", AsyncFileReader::Backend::IoUring, 32, true},
+    };
+    for (const Config& config : configs) {
+        AsyncFileReader::Options options;
+        options.backend = config.backend;
+        options.queueDepth = config.depth;
+        options.direct = config.direct;
+        measure(config.label, path, bytes, [&](auto& consumer) {
+            try {
+                AsyncFileReader(options).read(path, consumer);
+                return std::string();
+            } catch (const std::exception& e) {
+                return std::string("(unavailable: ") + e.what() + ")";
+            }
+        });
+    }
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    std::remove(path.c_str());
+    return 0;
+}
+
+/*
+ * Explanation:
+ *
+ * 1. Keeping the device busy:
+ *    - With one blocking read at a time, the device has at most one request, and none while the
+ *      consumer runs. With N reads in flight, the device (especially an SSD) can work on several
+ *      requests in parallel, and new data keeps arriving while the consumer processes a block.
+ *
+ * 2. io_uring vs threads:
+ *    - Both keep N reads in flight. The thread pool needs N threads, each blocked in pread, plus
+ *      the locking and wake-ups to hand blocks over. io_uring needs one system call per submitted
+ *      block and one thread, and the kernel completes reads without waking any thread of ours.
+ *
+ * 3. O_DIRECT:
+ *    - Buffered reads copy every byte from the page cache into our buffer, and the kernel's
+ *      read-ahead decides how much I/O is in flight. O_DIRECT moves data from the device straight
+ *      into the aligned buffers, which saves the copy and the page-cache memory; the queue depth
+ *      then fully controls the parallelism. With depth 1 and O_DIRECT nothing reads ahead at all,
+ *      so the device sits idle while the consumer runs.
+ *
+ * 4. Reading the CPU column:
+ *    - CPU % is user + system time of all threads divided by wall time. At the same MB/s, a lower
+ *      value means more CPU left for other work; a value near 100% on a single core means the read
+ *      loop, not the device, has become the bottleneck.
+ *
+ * Tips and Tricks:
+ * - Measure with a cold page cache; a warm cache only measures memcpy. On a virtual machine the
+ *   host may still cache the disk image, so absolute numbers vary a lot between systems.
+ * - Larger blocks mean fewer system calls; more depth helps fast NVMe SSDs. 1 MB x 8 is a good start.
+ * - Probe for the operations you use (IORING_REGISTER_PROBE) instead of treating a successful
+ *   io_uring_setup as proof: the opcode set grew release by release.
+ * - Keep one ring alive for many files instead of creating one per file; setup costs several
+ *   system calls and mmaps.
+ * - If a completion can throw, wait for every in-flight read before freeing the buffers: the kernel
+ *   writes into them asynchronously.
+ */